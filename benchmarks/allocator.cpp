@@ -0,0 +1,216 @@
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "allocator.h"
+
+namespace pool {
+
+namespace {
+
+const size_t ChunkSize = size_t(2) << 20;
+const int MaxSizeClasses = 8;
+
+std::atomic<bool> sEnabled{false};
+bool sAssetPool = false;
+
+size_t sSizes[MaxSizeClasses] = {};
+int sSizeCount = 0;
+
+char* sBase = nullptr;
+size_t sReserved = 0;
+std::atomic<size_t> sChunkCount{0};
+unsigned char* sChunkClasses = nullptr;     // the size class of each chunk
+
+// the cache of a thread is never destroyed, so that objects freed by other threads can always
+// be handed back to the thread that owns their chunk, even after that thread has exited
+
+struct ThreadCache
+{
+    struct SizeClass
+    {
+        char* next = nullptr;
+        char* end = nullptr;
+        void* freeList = nullptr;
+        std::atomic<void*> remoteFreeList{nullptr};     // objects freed by other threads
+    };
+
+    SizeClass sizeClasses[MaxSizeClasses];
+};
+
+ThreadCache** sChunkOwners = nullptr;       // the thread cache that owns each chunk
+
+ThreadCache& threadCache()
+{
+    thread_local ThreadCache* cache = new (malloc(sizeof(ThreadCache))) ThreadCache;
+    return *cache;
+}
+
+// returns the size class of the size or -1 if there is no matching size class
+
+inline int sizeClass(size_t size)
+{
+    for (int i = 0; i < sSizeCount; i++) {
+        if (sSizes[i] == size)  return i;
+    }
+    return -1;
+}
+
+inline bool contains(void* ptr)
+{
+    return ptr >= sBase && ptr < sBase + sReserved;
+}
+
+void* allocate(int index)
+{
+    ThreadCache& cache = threadCache();
+    ThreadCache::SizeClass& sizeClass = cache.sizeClasses[index];
+
+    // reclaim the objects freed by other threads once the local free list runs out
+
+    if (!sizeClass.freeList) {
+        sizeClass.freeList = sizeClass.remoteFreeList.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    if (sizeClass.freeList) {
+        void* ptr = sizeClass.freeList;
+        sizeClass.freeList = *static_cast<void**>(ptr);
+        return ptr;
+    }
+
+    // objects are 16-byte aligned by rounding up the size of the slot
+
+    const size_t slot = (sSizes[index] + 15) & ~size_t(15);
+
+    if (sizeClass.next + slot > sizeClass.end) {
+        const size_t chunk = sChunkCount++;
+        if ((chunk + 1) * ChunkSize > sReserved)    return nullptr;
+        sChunkClasses[chunk] = static_cast<unsigned char>(index);
+        sChunkOwners[chunk] = &cache;
+        sizeClass.next = sBase + chunk * ChunkSize;
+        sizeClass.end = sizeClass.next + ChunkSize;
+    }
+
+    void* ptr = sizeClass.next;
+    sizeClass.next += slot;
+    return ptr;
+}
+
+// objects are returned to the free list of the thread that owns their chunk, directly when
+// freed by that thread and through its lock-free remote free list otherwise
+
+void deallocate(void* ptr)
+{
+    const size_t chunk = (static_cast<char*>(ptr) - sBase) / ChunkSize;
+    ThreadCache& owner = *sChunkOwners[chunk];
+    ThreadCache::SizeClass& sizeClass = owner.sizeClasses[sChunkClasses[chunk]];
+
+    if (&owner == &threadCache()) {
+        *static_cast<void**>(ptr) = sizeClass.freeList;
+        sizeClass.freeList = ptr;
+        return;
+    }
+
+    void* head = sizeClass.remoteFreeList.load(std::memory_order_relaxed);
+    do {
+        *static_cast<void**>(ptr) = head;
+    } while (!sizeClass.remoteFreeList.compare_exchange_weak(head, ptr,
+        std::memory_order_release, std::memory_order_relaxed));
+}
+
+} // namespace
+
+void registerSize(size_t size)
+{
+    if (sizeClass(size) >= 0 || sSizeCount == MaxSizeClasses || size < sizeof(void*) || size > ChunkSize)  return;
+    sSizes[sSizeCount++] = size;
+}
+
+bool initialize(bool hugePages)
+{
+    if (sBase)  return true;
+
+    // reserve as much address space as possible, pages are only committed once touched
+
+    for (size_t reserve = size_t(1) << 40; reserve >= (size_t(1) << 30); reserve >>= 1) {
+        void* ptr = mmap(nullptr, reserve + ChunkSize, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr == MAP_FAILED)  continue;
+
+        // align the start of the range to the chunk size so that chunks can be backed by huge pages
+
+        const uintptr_t aligned = (reinterpret_cast<uintptr_t>(ptr) + ChunkSize - 1) & ~uintptr_t(ChunkSize - 1);
+        sBase = reinterpret_cast<char*>(aligned);
+        sReserved = reserve;
+        sChunkClasses = static_cast<unsigned char*>(calloc(reserve / ChunkSize, 1));
+        sChunkOwners = static_cast<ThreadCache**>(calloc(reserve / ChunkSize, sizeof(ThreadCache*)));
+
+#ifdef MADV_HUGEPAGE
+        if (hugePages)  madvise(sBase, sReserved, MADV_HUGEPAGE);
+#endif
+        return true;
+    }
+
+    return false;
+}
+
+void enable(bool enabled)
+{
+    sEnabled = enabled && sBase != nullptr;
+}
+
+bool enabled()
+{
+    return sEnabled;
+}
+
+void setAssetPool(bool enabled)
+{
+    sAssetPool = enabled;
+}
+
+bool assetPool()
+{
+    return sAssetPool;
+}
+
+size_t bytesReserved()
+{
+    return std::min(sChunkCount.load(), sReserved / ChunkSize) * ChunkSize;
+}
+
+} // namespace pool
+
+
+// the replacements of the global allocation functions, the array and nothrow variants of the
+// standard library forward to these
+
+void* operator new(size_t size)
+{
+    if (pool::sEnabled.load(std::memory_order_relaxed)) {
+        const int index = pool::sizeClass(size);
+        if (index >= 0) {
+            if (void* ptr = pool::allocate(index))  return ptr;
+        }
+    }
+
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr)   throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (pool::contains(ptr))    pool::deallocate(ptr);
+    else                        free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <cstddef>
+
+// a size-class pool allocator for tree nodes that is installed by replacing the global
+// operator new and delete of the benchmark executables (see allocator.cpp)
+//
+// while a pool scope is active, allocations of exactly one of the registered sizes are carved
+// from 2MB chunks of a single reserved virtual address range, with each chunk dedicated to
+// one size class and owned by one thread, which has a bump pointer and free list for every size
+// class, all other allocations and all allocations made outside of a pool scope go to the
+// system allocator
+//
+// the pool only captures by size, so any other allocation of a registered size made on any
+// thread while a scope is active also comes from the pool, which is why scopes should only
+// wrap the construction of trees
+
+namespace pool {
+
+// register a size class, at most eight size classes can be registered and registration
+// must happen before the pool is first enabled
+
+void registerSize(size_t size);
+
+// register the sizes of the leaf nodes, leaf buffers and internal nodes of a tree type
+
+template <typename TreeT>
+inline void registerTree()
+{
+    using LeafT = typename TreeT::LeafNodeType;
+    using UpperT = typename TreeT::RootNodeType::ChildNodeType;
+    using LowerT = typename UpperT::ChildNodeType;
+
+    registerSize(sizeof(LeafT));
+    registerSize(sizeof(typename TreeT::ValueType) * LeafT::SIZE);
+    registerSize(sizeof(LowerT));
+    registerSize(sizeof(UpperT));
+}
+
+// reserve the address range of the pool, optionally backed by transparent 2MB huge pages,
+// returns false if the range could not be reserved in which case the pool stays disabled
+
+bool initialize(bool hugePages);
+
+void enable(bool enabled);
+bool enabled();
+
+// whether the trees of the loaded assets are allocated from the pool, which also applies to the
+// working copies of the asset that benchmarks mutate in place of it
+
+void setAssetPool(bool enabled);
+bool assetPool();
+
+// the number of bytes of the chunks handed out to size classes so far
+
+size_t bytesReserved();
+
+// enables the pool for the lifetime of this object if requested, the pool is disabled outside
+// of all scopes
+
+class Scope
+{
+public:
+    Scope(bool enabled_): mPrevious(enabled()) { enable(enabled_); }
+    ~Scope() { enable(mPrevious); }
+
+private:
+    bool mPrevious;
+};
+
+} // namespace pool
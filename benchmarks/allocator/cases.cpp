@@ -0,0 +1,244 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include "../allocator.h"
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+// run the op with the nodes of all trees it allocates coming from the pool or the system allocator
+
+template <typename OpT>
+Result withAllocator(const Context& ctx, bool usePool, const OpT& op)
+{
+    if (usePool) {
+        pool::registerTree<FloatTree>();
+        if (!pool::initialize(ctx.parser.has("-hugepages"))) {
+            return Result::skip("the address range of the pool could not be reserved");
+        }
+    }
+
+    Result result = op();
+
+    if (usePool)    result.metric("pool", double(pool::bytesReserved()) / (1024.0 * 1024.0), "MB");
+    return result;
+}
+
+double copyTree(const FloatTree& refTree, bool usePool, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        std::unique_ptr<FloatTree> tree;
+        {
+            pool::Scope scope(usePool);
+            tree.reset(new FloatTree(refTree));
+        }
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double voxelizeActiveTiles(const FloatTree& refTree, bool usePool, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    for (int i = 0; i < iterations; i++) {
+
+        pool::Scope scope(usePool);
+
+        // replace every leaf with an active tile of the same size
+
+        FloatTree tree(refTree.background());
+        for (auto leaf = refTree.cbeginLeaf(); leaf; ++leaf) {
+            tree.addTile(/*level=*/1, leaf->origin(), leaf->getFirstValue(), true);
+        }
+
+        evictCache();
+
+        timer.start();
+
+        tree.voxelizeActiveTiles(threaded);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double constructTree(const FloatTree& refTree, bool usePool, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    std::vector<std::pair<Coord, float>> voxels;
+    for (auto leaf = refTree.cbeginLeaf(); leaf; ++leaf) {
+        for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+            voxels.emplace_back(iter.getCoord(), iter.getValue());
+        }
+    }
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        std::unique_ptr<FloatTree> tree;
+        {
+            pool::Scope scope(usePool);
+            tree.reset(new FloatTree(refTree.background()));
+            tree::ValueAccessor<FloatTree> valueAccessor(*tree);
+            for (const auto& voxel : voxels) {
+                valueAccessor.setValue(voxel.first, voxel.second);
+            }
+        }
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueLeafManager(const FloatTree& refTree, bool usePool, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    std::unique_ptr<FloatTree> tree;
+    {
+        pool::Scope scope(usePool);
+        tree.reset(new FloatTree(refTree));
+    }
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        tree::LeafManager<FloatTree> leafManager(*tree);
+        leafManager.foreach([](FloatTree::LeafNodeType& leaf, size_t) {
+            for (auto iter = leaf.beginValueOn(); iter; ++iter) {
+                iter.setValue(iter.getValue() * 2);
+            }
+        }, threaded, /*grainSize=*/1);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double getValueSequentialLeaf(const FloatTree& refTree, bool usePool, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    std::unique_ptr<FloatTree> tree;
+    {
+        pool::Scope scope(usePool);
+        tree.reset(new FloatTree(refTree));
+    }
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        for (auto leaf = tree->cbeginLeaf(); leaf; ++leaf) {
+            for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                total += iter.getValue();
+            }
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+double getValueSequentialChild(const FloatTree& refTree, bool usePool, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    std::unique_ptr<FloatTree> tree;
+    {
+        pool::Scope scope(usePool);
+        tree.reset(new FloatTree(refTree));
+    }
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        for (auto iter1 = tree->cbeginRootChildren(); iter1; ++iter1) {
+            for (auto iter2 = iter1->cbeginChildOn(); iter2; ++iter2) {
+                for (auto iter3 = iter2->cbeginChildOn(); iter3; ++iter3) {
+                    for (auto iter4 = iter3->cbeginValueOn(); iter4; ++iter4) {
+                        total += iter4.getValue();
+                    }
+                }
+            }
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+std::vector<Case> allocatorCases()
+{
+    std::vector<Case> cases;
+    for (bool usePool : { false, true }) {
+        const std::string prefix = usePool ? "Cloud Pool Allocator " : "Cloud System Allocator ";
+        cases.push_back({ prefix + "Copy Tree", Case::Asset | Case::Threaded,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(copyTree(ctx.tree(), usePool, ctx.iterations)); }); } });
+        cases.push_back({ prefix + "Voxelize Active Tiles", Case::Asset | Case::Serial | Case::Threaded,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(voxelizeActiveTiles(ctx.tree(), usePool, ctx.threaded, ctx.iterations)); }); } });
+        cases.push_back({ prefix + "Construct Tree", Case::Asset | Case::Serial,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(constructTree(ctx.tree(), usePool, ctx.iterations)); }); } });
+        cases.push_back({ prefix + "Set Value LeafManager", Case::Asset | Case::Serial | Case::Threaded,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(setValueLeafManager(ctx.tree(), usePool, ctx.threaded, ctx.iterations)); }); } });
+        cases.push_back({ prefix + "Get Value Sequential Leaf Iterator", Case::Asset | Case::Serial,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(getValueSequentialLeaf(ctx.tree(), usePool, ctx.iterations)); }); } });
+        cases.push_back({ prefix + "Get Value Sequential Hierarchy Iterator", Case::Asset | Case::Serial,
+            [=](const Context& ctx) { return withAllocator(ctx, usePool,
+                [&]() { return Result(getValueSequentialChild(ctx.tree(), usePool, ctx.iterations)); }); } });
+    }
+    return cases;
+}
+
+const bool registered = registerCases("allocator", allocatorCases());
+
+} // namespace
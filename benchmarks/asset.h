@@ -1,31 +1,142 @@
+#pragma once
 
 #include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+#include "snapshot.h"
+#include "stats.h"
 
 using namespace openvdb;
 
-FloatTree openVDBAsset(const std::string& filepath)
+struct Asset
 {
-    // open the VDB and extract the first grid
+    std::string filepath;
+    std::string grid;
+    FloatTree::Ptr tree;
+    TreeStats stats;
+};
 
+// expand a comma-separated list of VDB files and directories of VDB files into a list of
+// files, the files in a directory are sorted by name
+
+inline std::vector<std::string> vdbFiles(const std::string& paths)
+{
+    std::vector<std::string> result;
+
+    std::istringstream ss(paths);
+    std::string path;
+    while (std::getline(ss, path, ',')) {
+        if (path.empty())   continue;
+
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISDIR(st.st_mode)) {
+            result.push_back(path);
+            continue;
+        }
+
+        std::vector<std::string> files;
+        if (DIR* dir = opendir(path.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name.size() > 4 && name.compare(name.size() - 4, 4, ".vdb") == 0) {
+                    files.push_back(path + "/" + name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(files.begin(), files.end());
+        result.insert(result.end(), files.begin(), files.end());
+    }
+
+    return result;
+}
+
+// the names of the float grids in the VDB that match the selector, which is either the name of a
+// grid, "*" for every float grid or empty for the first float grid
+//
+// grids that share a name, such as several unnamed grids, are told apart by the "name[N]" form
+// of their names that io::File::readGrid accepts, where N counts the previous grids of that name
+
+inline std::vector<std::string> vdbGridNames(const std::string& filepath, const std::string& selector)
+{
     io::File file(filepath);
     file.open();
-    auto grids = file.getGrids();
+    auto grids = file.readAllGridMetadata();
+    file.close();
+
+    std::vector<std::string> result;
+    std::map<std::string, int> occurrences;
+    for (const auto& grid : *grids) {
+        const std::string& name = grid->getName();
+        const int occurrence = occurrences[name]++;
+        if (!selector.empty() && selector != "*" && selector != name)   continue;
+        if (!grid->isType<FloatGrid>())     continue;
+        result.push_back(occurrence == 0 ? name : name + "[" + std::to_string(occurrence) + "]");
+        if (selector.empty())   break;
+    }
+    return result;
+}
+
+inline FloatTree::Ptr preprocessVDBAsset(const std::string& filepath, const std::string& gridName, TreeStats& stats)
+{
+    // open the VDB and extract the grid, which is named as returned by vdbGridNames
+
+    io::File file(filepath);
+    file.open();
+    GridBase::Ptr gridBase = file.readGrid(gridName);
     file.close();
-    auto gridBase = (*grids)[0];
     auto grid = GridBase::grid<FloatGrid>(gridBase);
 
     // create a new tree and voxelize all active tiles
 
-    FloatTree tree(grid->tree());
-    tree.voxelizeActiveTiles();
+    FloatTree::Ptr tree = std::make_shared<FloatTree>(grid->tree());
+    stats = treeStats(*tree);
+    tree->voxelizeActiveTiles();
+
+    return tree;
+}
+
+// if a snapshot directory is provided, the preprocessed tree is loaded from a snapshot of the
+// asset in that directory or a snapshot is written after preprocessing if there is none yet
+
+inline Asset openVDBAsset(const std::string& filepath, const std::string& gridName,
+    const std::string& snapshots = "")
+{
+    util::CpuTimer timer;
+    timer.start();
+
+    Asset asset{filepath, gridName, nullptr, TreeStats()};
+
+    if (snapshots.empty()) {
+        asset.tree = preprocessVDBAsset(filepath, gridName, asset.stats);
+    } else {
+        const uint64_t key = snapshot::key(filepath, "grid " + gridName + "/voxelize active tiles");
+        const std::string path = snapshot::path(snapshots, key);
+        if (key != 0)   asset.tree = snapshot::read(path, key, asset.stats);
+        if (asset.tree) {
+            std::cerr << "Loaded snapshot " << path << " in " << timer.milliseconds() << "ms" << std::endl;
+        } else {
+            asset.tree = preprocessVDBAsset(filepath, gridName, asset.stats);
+            if (key != 0 && snapshot::write(path, key, *asset.tree, asset.stats)) {
+                std::cerr << "Wrote snapshot " << path << std::endl;
+            }
+        }
+    }
 
     // warm up
 
     float total = 0.0f;
-    for (auto iter = tree.cbeginValueOn(); iter; ++iter) {
+    for (auto iter = asset.tree->cbeginValueOn(); iter; ++iter) {
         total += iter.getValue();
     }
     if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
 
-    return tree;
+    return asset;
 }
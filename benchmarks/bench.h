@@ -0,0 +1,87 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cache.h"
+#include "parse.h"
+
+struct Metric
+{
+    std::string name;
+    double value;
+    std::string units;
+};
+
+struct Result
+{
+    double time = 0.0;          // average milliseconds per iteration
+    std::vector<Metric> metrics;
+    std::string skipped;        // reason the benchmark did not run, empty if it did
+
+    Result() = default;
+    Result(double time_): time(time_) { }
+
+    Result& metric(const std::string& name, double value, const std::string& units = "")
+    {
+        metrics.push_back({name, value, units});
+        return *this;
+    }
+
+    static Result skip(const std::string& reason)
+    {
+        Result result;
+        result.skipped = reason;
+        return result;
+    }
+};
+
+struct Context
+{
+    const OptParse& parser;
+    const openvdb::FloatTree* asset;    // nullptr unless the benchmark requested the asset
+    std::string vdb;                    // the file and grid the asset was loaded from
+    std::string grid;
+    int iterations;
+    int cpus;
+    bool threaded;
+    int threads;                        // maximum allowed parallelism for this run
+
+    const openvdb::FloatTree& tree() const { return *asset; }
+};
+
+struct Case
+{
+    enum Flags
+    {
+        Serial = 1,     // run once single-threaded
+        Threaded = 2,   // run once per power-of-two thread count up to -cpus
+        Asset = 4       // requires the VDB asset to be loaded
+    };
+
+    std::string name;
+    int flags;
+    std::function<Result(const Context&)> run;
+    std::string suite;
+};
+
+inline std::vector<Case>& registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+// register the benchmarks of a suite in the order in which they should be run,
+// intended to be called from the initializer of a namespace-scope variable
+
+inline bool registerCases(const std::string& suite, std::vector<Case> cases)
+{
+    for (auto& benchmark : cases) {
+        benchmark.suite = suite;
+        registry().push_back(std::move(benchmark));
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <memory>
+#include <vector>
+
+struct CacheControl
+{
+    bool cold = false;      // evict the caches before every timed iteration
+    bool remap = false;     // also move read-only trees to new memory before every timed iteration
+    std::vector<char> buffer;
+    volatile char sink = 0;
+
+    // stream through a buffer of twice the size of the last-level cache, writing to every
+    // cache line so that dirty lines are evicted too (only the caches of the calling thread
+    // and the shared LLC are affected, the private caches of other cores are left untouched)
+
+    void evict()
+    {
+        if (buffer.empty()) {
+            long bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+            if (bytes <= 0)     bytes = 64 * 1024 * 1024;
+            buffer.resize(size_t(bytes) * 2);
+        }
+
+        const size_t stride = 64;
+        char total = 0;
+        for (size_t i = 0; i < buffer.size(); i += stride) {
+            buffer[i] += 1;
+            total += buffer[i];
+        }
+        sink = total; // prevent optimization
+    }
+};
+
+inline CacheControl& cacheControl()
+{
+    static CacheControl control;
+    return control;
+}
+
+// call before starting the timer of each iteration, does nothing when measuring a warm cache
+
+inline void evictCache()
+{
+    CacheControl& control = cacheControl();
+    if (control.cold)   control.evict();
+}
+
+// returns a deep copy of the tree at a new address when remapping a cold cache, the previous
+// copy is only released after the new one has been allocated so that its memory is not reused,
+// writing the copy leaves it hot in the caches and TLB, so call evictCache() afterwards
+
+template <typename TreeT>
+inline const TreeT& remapTree(const TreeT& tree, std::unique_ptr<TreeT>& copy)
+{
+    const CacheControl& control = cacheControl();
+    if (!control.cold || !control.remap)    return tree;
+    std::unique_ptr<TreeT> next(new TreeT(tree));
+    copy.swap(next);
+    return *copy;
+}
@@ -0,0 +1,243 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../bench.h"
+#include "../patterns.h"
+
+using namespace openvdb;
+
+namespace {
+
+enum class Write
+{
+    None,           // readers only
+    SetValueOnly,   // overwrite the values of active voxels in leaves owned by the writer
+    ModifyValue,    // increment the values of active voxels in leaves owned by the writer
+    AddLeaves       // fill empty leaf slots of the lower internal nodes owned by the writer
+};
+
+// readers time batches of queries and create a new accessor for every batch, which is
+// when accessor registration with the tree is paid
+
+const size_t BatchSize = 256;
+
+using Clock = std::chrono::steady_clock;
+
+// the coordinates each writer updates or the origins of the leaves each writer adds, leaves
+// are only added to existing lower internal nodes and a whole internal node is owned by one
+// writer, inserting nodes into the root or into the same internal node from multiple threads
+// is not thread-safe, neither is adding a leaf into an internal node slot that a reader queries
+
+std::vector<std::vector<Coord>> writerIJKs(const FloatTree& tree, Write write, int writers)
+{
+    std::vector<std::vector<Coord>> ijks(writers);
+
+    if (write == Write::AddLeaves) {
+        int n = 0;
+        for (auto iter1 = tree.cbeginRootChildren(); iter1; ++iter1) {
+            for (auto iter2 = iter1->cbeginChildOn(); iter2; ++iter2) {
+                auto& writerIJK = ijks[n++ % writers];
+                for (auto iter3 = iter2->cbeginChildOff(); iter3; ++iter3) {
+                    writerIJK.push_back(iter3.getCoord());
+                }
+            }
+        }
+    } else if (write != Write::None) {
+        int n = 0;
+        for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+            auto& writerIJK = ijks[n++ % writers];
+            for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                writerIJK.push_back(iter.getCoord());
+            }
+        }
+    }
+
+    return ijks;
+}
+
+template <bool Registered>
+void readValues(const FloatTree& tree, const Coord* begin, const Coord* end, std::vector<double>& latencies)
+{
+    float total = 0.0f;
+
+    for (const Coord* batch = begin; batch < end; batch += BatchSize) {
+        const Coord* batchEnd = std::min(batch + BatchSize, end);
+
+        const auto start = Clock::now();
+
+        tree::ValueAccessor<const FloatTree, Registered> valueAccessor(tree);
+        for (const Coord* ijk = batch; ijk < batchEnd; ++ijk) {
+            total += valueAccessor.getValue(*ijk);
+        }
+
+        const std::chrono::duration<double, std::nano> duration = Clock::now() - start;
+        latencies.push_back(duration.count() / double(batchEnd - batch));
+    }
+
+    if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+}
+
+// write until the readers have finished, returns the number of voxels written
+
+template <bool Registered>
+size_t writeValues(FloatTree& tree, Write write, const std::vector<Coord>& ijks, const std::atomic<bool>& done)
+{
+    tree::ValueAccessor<FloatTree, Registered> valueAccessor(tree);
+    size_t count = 0;
+
+    if (write == Write::AddLeaves) {
+        for (const auto& ijk : ijks) {
+            if (done)   break;
+            valueAccessor.touchLeaf(ijk)->fill(1.0f, /*active=*/true);
+            count += FloatTree::LeafNodeType::SIZE;
+        }
+        return count;
+    }
+
+    while (!done && !ijks.empty()) {
+        for (const auto& ijk : ijks) {
+            if (write == Write::SetValueOnly) {
+                valueAccessor.setValueOnly(ijk, 1.0f);
+            } else {
+                valueAccessor.modifyValue(ijk, [](float& value) { value += 1.0f; });
+            }
+            if ((++count % BatchSize) == 0 && done)     break;
+        }
+    }
+    return count;
+}
+
+double percentile(std::vector<double>& values, double fraction)
+{
+    if (values.empty())     return 0.0;
+    const size_t n = std::min(values.size() - 1, size_t(fraction * double(values.size())));
+    std::nth_element(values.begin(), values.begin() + n, values.end());
+    return values[n];
+}
+
+template <bool Registered>
+Result readWhileWriting(const FloatTree& refTree, Write writeType, int writers, int threads, int iterations)
+{
+    // the readers and writers share the thread budget of the run, so that the thread count of a
+    // result is the number of threads that actually ran
+
+    if (writeType == Write::None)   writers = 0;
+    if (writers >= threads)     return Result::skip("at least one reader thread is required in addition to the writers");
+    const int readers = threads - writers;
+
+    std::vector<Coord> ijks;
+    addActiveVoxelIJKs(refTree, ijks);
+    const std::vector<std::vector<Coord>> ijksWriters = writerIJKs(refTree, writeType, std::max(writers, 1));
+
+    double time = 0.0f;
+    size_t writes = 0;
+    std::vector<double> latencies;
+
+    for (int i = 0; i < iterations; i++) {
+
+        // the writers mutate the tree so every iteration starts from a new copy
+
+        FloatTree tree(refTree);
+
+        std::vector<std::vector<double>> readerLatencies(readers);
+        std::vector<size_t> writerCounts(writers, 0);
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::atomic<bool> done{false};
+        std::atomic<int> finished{0};
+
+        std::vector<std::thread> threadPool;
+        for (int r = 0; r < readers; r++) {
+            threadPool.emplace_back([&, r]() {
+                const Coord* begin = ijks.data() + ijks.size() * r / readers;
+                const Coord* end = ijks.data() + ijks.size() * (r + 1) / readers;
+                ready++;
+                while (!go)     std::this_thread::yield();
+                readValues<Registered>(tree, begin, end, readerLatencies[r]);
+                if (++finished == readers)  done = true;
+            });
+        }
+        for (int w = 0; w < writers; w++) {
+            threadPool.emplace_back([&, w]() {
+                ready++;
+                while (!go)     std::this_thread::yield();
+                writerCounts[w] = writeValues<Registered>(tree, writeType, ijksWriters[w], done);
+            });
+        }
+
+        while (ready < readers + writers)     std::this_thread::yield();
+
+        evictCache();
+
+        const auto start = Clock::now();
+        go = true;
+        while (!done)   std::this_thread::yield();
+        const std::chrono::duration<double, std::milli> duration = Clock::now() - start;
+
+        for (auto& thread : threadPool)     thread.join();
+
+        time += duration.count();
+        for (size_t count : writerCounts)   writes += count;
+        for (const auto& readerLatency : readerLatencies) {
+            latencies.insert(latencies.end(), readerLatency.begin(), readerLatency.end());
+        }
+    }
+
+    time /= iterations;
+
+    Result result(time);
+    result.metric("readers", readers).metric("writers", writers)
+        .metric("p50", percentile(latencies, 0.5), "ns")
+        .metric("p90", percentile(latencies, 0.9), "ns")
+        .metric("p99", percentile(latencies, 0.99), "ns")
+        .metric("max", percentile(latencies, 1.0), "ns");
+    if (writers > 0) {
+        result.metric("writer throughput", double(writes) / iterations / (time * 1000.0), "M voxels/s");
+    }
+    return result;
+}
+
+const char* writeName(Write write)
+{
+    switch (write) {
+        case Write::None:           return "No Writer";
+        case Write::SetValueOnly:   return "Set Value Only";
+        case Write::ModifyValue:    return "Modify Value";
+        case Write::AddLeaves:      return "Add Leaves";
+    }
+    return "";
+}
+
+std::vector<Case> concurrencyCases()
+{
+    std::vector<Case> cases;
+    for (bool registered : { true, false }) {
+        const std::string suffix = registered ? " Registered" : " Unregistered";
+        for (Write write : { Write::None, Write::SetValueOnly, Write::ModifyValue, Write::AddLeaves }) {
+            for (int writers : { 1, 4 }) {
+                if (write == Write::None && writers > 1)    continue;
+                std::string name = "Cloud Readers ";
+                if (write != Write::None) {
+                    name += std::to_string(writers) + (writers == 1 ? " Writer " : " Writers ");
+                }
+                cases.push_back({ name + writeName(write) + suffix, Case::Asset | Case::Threaded,
+                    [=](const Context& ctx) {
+                        return registered ?
+                            readWhileWriting<true>(ctx.tree(), write, writers, ctx.threads, ctx.iterations) :
+                            readWhileWriting<false>(ctx.tree(), write, writers, ctx.threads, ctx.iterations);
+                    } });
+            }
+        }
+    }
+    return cases;
+}
+
+const bool registered = registerCases("concurrency", concurrencyCases());
+
+} // namespace
@@ -0,0 +1,271 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+
+#include <functional>
+#include <memory>
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+// a prototype of copy-on-write sharing at the granularity of leaf nodes, an array of the leaf
+// nodes of the source tree in which a leaf is only replaced by a private copy the first time
+// it is written to
+//
+// this is not a tree, it has no internal nodes and its leaves can only be accessed by their
+// index in leaf order, so it measures the cost of sharing the leaf array, of the first writes
+// and of reading through the shared leaves, but not of cloning or querying a tree by coordinate
+
+class SharedLeafArray
+{
+public:
+    using LeafT = FloatTree::LeafNodeType;
+
+    SharedLeafArray(const FloatTree& tree):
+        mLeafManager(tree), mLeaves(mLeafManager.leafCount()) { }
+
+    size_t leafCount() const { return mLeaves.size(); }
+
+    const LeafT& readLeaf(size_t i) const
+    {
+        return mLeaves[i] ? *mLeaves[i] : mLeafManager.leaf(i);
+    }
+
+    // not thread-safe for the same leaf index
+
+    LeafT& writeLeaf(size_t i)
+    {
+        if (!mLeaves[i])    mLeaves[i].reset(new LeafT(mLeafManager.leaf(i)));
+        return *mLeaves[i];
+    }
+
+    // the memory owned by the leaf array, which excludes the leaves shared with the source
+
+    Index64 memUsage() const
+    {
+        Index64 result = sizeof(*this) + mLeaves.capacity() * sizeof(std::unique_ptr<LeafT>) +
+            mLeafManager.leafCount() * sizeof(LeafT*);
+        for (const auto& leaf : mLeaves) {
+            if (leaf)   result += leaf->memUsage();
+        }
+        return result;
+    }
+
+    // the memory of the leaves of the source that are still shared with the leaf array
+
+    Index64 sharedMemUsage() const
+    {
+        Index64 result = 0;
+        for (size_t i = 0; i < mLeaves.size(); i++) {
+            if (!mLeaves[i])    result += mLeafManager.leaf(i).memUsage();
+        }
+        return result;
+    }
+
+private:
+    tree::LeafManager<const FloatTree> mLeafManager;
+    std::vector<std::unique_ptr<LeafT>> mLeaves;
+};
+
+// a shallow copy of a grid shares its tree, so it does not allocate any tree memory
+
+struct SharedGrid
+{
+    FloatGrid::ConstPtr grid;
+
+    Index64 memUsage() const { return sizeof(FloatGrid); }
+};
+
+double megabytes(Index64 bytes)
+{
+    return double(bytes) / (1024.0 * 1024.0);
+}
+
+// time the op which returns a pointer to a new copy, the copy is destroyed outside of the timer
+
+template <typename CopyOp>
+Result timeCopy(const CopyOp& op, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    Index64 memory = 0;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        auto result = op();
+
+        time += timer.milliseconds();
+
+        memory = result->memUsage();
+    }
+
+    return Result(time/iterations).metric("memory", megabytes(memory), "MB");
+}
+
+// sum the active values of the leaves in leaf order, where leaf(n) returns the n-th leaf
+
+template <typename LeafOp>
+float sumLeaves(size_t leafCount, const LeafOp& leaf)
+{
+    return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, leafCount), 0.0f,
+        [&](const tbb::blocked_range<size_t>& range, float total) {
+            for (size_t n = range.begin(); n < range.end(); n++) {
+                for (auto iter = leaf(n).cbeginValueOn(); iter; ++iter) {
+                    total += iter.getValue();
+                }
+            }
+            return total;
+        }, std::plus<float>());
+}
+
+// share the leaves of the tree and then double the values of a fraction of the leaf nodes,
+// which is when the written leaf nodes are copied, then read every leaf of the shared leaf array
+// and of a deep copy of the tree to compare the cost of reading through shared leaves
+
+Result shareLeaves(const FloatTree& refTree, double fraction, int iterations)
+{
+    util::CpuTimer timer;
+    double shareTime = 0.0f;
+    double writeTime = 0.0f;
+    double readTime = 0.0f;
+    double deepReadTime = 0.0f;
+    Index64 memory = 0;
+    Index64 sharedMemory = 0;
+    float total = 0.0f;
+
+    FloatTree deepTree(refTree);
+    tree::LeafManager<const FloatTree> deepLeafManager(deepTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        std::unique_ptr<SharedLeafArray> leafArray(new SharedLeafArray(refTree));
+
+        shareTime += timer.milliseconds();
+
+        timer.start();
+
+        // write to leaves evenly distributed through the tree
+
+        const size_t stride = fraction > 0.0 ? std::max(size_t(1), size_t(1.0 / fraction)) : 0;
+        const size_t count = stride > 0 ? (leafArray->leafCount() + stride - 1) / stride : 0;
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count),
+            [&](const tbb::blocked_range<size_t>& range) {
+                for (size_t n = range.begin(); n < range.end(); n++) {
+                    auto& leaf = leafArray->writeLeaf(n * stride);
+                    for (auto iter = leaf.beginValueOn(); iter; ++iter) {
+                        iter.setValue(iter.getValue() * 2);
+                    }
+                }
+            });
+
+        writeTime += timer.milliseconds();
+
+        evictCache();
+
+        timer.start();
+
+        total += sumLeaves(leafArray->leafCount(), [&](size_t n) -> const SharedLeafArray::LeafT& { return leafArray->readLeaf(n); });
+
+        readTime += timer.milliseconds();
+
+        evictCache();
+
+        timer.start();
+
+        total += sumLeaves(deepLeafManager.leafCount(), [&](size_t n) -> const SharedLeafArray::LeafT& { return deepLeafManager.leaf(n); });
+
+        deepReadTime += timer.milliseconds();
+
+        memory = leafArray->memUsage();
+        sharedMemory = leafArray->sharedMemUsage();
+    }
+
+    if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+
+    shareTime /= iterations;
+    writeTime /= iterations;
+    readTime /= iterations;
+    deepReadTime /= iterations;
+
+    return Result(shareTime + writeTime)
+        .metric("share", shareTime, "ms")
+        .metric("write", writeTime, "ms")
+        .metric("read", readTime, "ms")
+        .metric("deep copy read", deepReadTime, "ms")
+        .metric("memory", megabytes(memory), "MB")
+        .metric("shared", megabytes(sharedMemory), "MB");
+}
+
+Result copyConstructor(const FloatTree& refTree, int iterations)
+{
+    return timeCopy([&]() { return std::make_unique<FloatTree>(refTree); }, iterations);
+}
+
+Result copyGridDeep(const FloatTree& refTree, int iterations)
+{
+    FloatGrid::ConstPtr grid = FloatGrid::create(std::make_shared<FloatTree>(refTree));
+    return timeCopy([&]() { return grid->deepCopy(); }, iterations);
+}
+
+Result copyGridShallow(const FloatTree& refTree, int iterations)
+{
+    FloatGrid::ConstPtr grid = FloatGrid::create(std::make_shared<FloatTree>(refTree));
+    return timeCopy([&]() { return std::make_unique<SharedGrid>(SharedGrid{grid->copy()}); }, iterations);
+}
+
+Result copyTopology(const FloatTree& refTree, int iterations)
+{
+    return timeCopy([&]() {
+        return std::make_unique<FloatTree>(refTree, refTree.background(), TopologyCopy());
+    }, iterations);
+}
+
+Result copyTopologyToMask(const FloatTree& refTree, int iterations)
+{
+    return timeCopy([&]() { return std::make_unique<MaskTree>(refTree, false, TopologyCopy()); }, iterations);
+}
+
+Result copyToDouble(const FloatTree& refTree, int iterations)
+{
+    return timeCopy([&]() { return std::make_unique<DoubleTree>(refTree); }, iterations);
+}
+
+const bool registered = registerCases("copy", {
+    { "Cloud Copy Tree Constructor", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return copyConstructor(ctx.tree(), ctx.iterations); } },
+    { "Cloud Copy Grid Deep Copy", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return copyGridDeep(ctx.tree(), ctx.iterations); } },
+    { "Cloud Copy Grid Shallow Copy", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return copyGridShallow(ctx.tree(), ctx.iterations); } },
+    { "Cloud Copy Topology", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return copyTopology(ctx.tree(), ctx.iterations); } },
+    { "Cloud Copy Topology To Mask", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return copyTopologyToMask(ctx.tree(), ctx.iterations); } },
+    { "Cloud Copy To Double", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return copyToDouble(ctx.tree(), ctx.iterations); } },
+    { "Cloud Shared Leaf Array No Writes", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return shareLeaves(ctx.tree(), 0.0, ctx.iterations); } },
+    { "Cloud Shared Leaf Array 10% Leaves Written", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return shareLeaves(ctx.tree(), 0.1, ctx.iterations); } },
+    { "Cloud Shared Leaf Array All Leaves Written", Case::Asset | Case::Threaded,
+        [](const Context& ctx) { return shareLeaves(ctx.tree(), 1.0, ctx.iterations); } },
+});
+
+} // namespace
@@ -0,0 +1,232 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/parallel_for.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#include "../bench.h"
+#include "../patterns.h"
+
+using namespace openvdb;
+
+namespace {
+
+// the grid of the VDB that the asset was loaded from, with delayed loading the leaf buffers stay
+// out-of-core in the memory-mapped file until they are first accessed, the active tiles are not
+// voxelized as that would load every leaf
+//
+// io::File copies files below OPENVDB_DELAYED_LOAD_COPY_MAX_BYTES to a private temporary file
+// before mapping them, which would add a full copy to the open time and leave the mapped copy
+// in the page cache, so the copy is disabled to always map the VDB itself
+
+FloatTree::Ptr openTree(const std::string& filepath, const std::string& gridName, bool delayed, double& time)
+{
+    util::CpuTimer timer;
+    timer.start();
+
+    io::File file(filepath);
+    file.setCopyMaxBytes(0);
+    file.open(delayed);
+    auto grid = GridBase::grid<FloatGrid>(file.readGrid(gridName));
+    file.close();
+
+    time += timer.milliseconds();
+
+    return grid ? grid->treePtr() : nullptr;
+}
+
+// with a cold cache, also drop the VDB from the page cache so leaves are paged in from disk
+
+void evictFile(const std::string& filepath)
+{
+    if (!cacheControl().cold)   return;
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)     return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// the bytes this process has caused to be read from storage, which includes the readahead
+// triggered by page faults on the memory-mapped file, zero if /proc/self/io is unavailable
+
+uint64_t readBytes()
+{
+    std::ifstream file("/proc/self/io");
+    std::string field;
+    uint64_t value = 0;
+    while (file >> field >> value) {
+        if (field == "read_bytes:")    return value;
+    }
+    return 0;
+}
+
+size_t outOfCoreLeafCount(const FloatTree& tree)
+{
+    size_t count = 0;
+    for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+        if (leaf->buffer().isOutOfCore())   count++;
+    }
+    return count;
+}
+
+template <typename AccessOp>
+Result delayedLoad(const std::string& filepath, const std::string& gridName, bool delayed, size_t queries,
+    int iterations, const AccessOp& op)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    double openTime = 0.0f;
+    double leavesLoaded = 0.0;
+    double pagedIn = 0.0;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictFile(filepath);
+
+        FloatTree::Ptr tree = openTree(filepath, gridName, delayed, openTime);
+        if (!tree)  return Result::skip("the grid is not a float grid");
+
+        const size_t outOfCore = outOfCoreLeafCount(*tree);
+        const uint64_t bytes = readBytes();
+
+        evictCache();
+
+        timer.start();
+
+        op(*tree);
+
+        time += timer.milliseconds();
+
+        leavesLoaded += double(outOfCore - outOfCoreLeafCount(*tree));
+        pagedIn += double(readBytes() - bytes);
+    }
+
+    time /= iterations;
+
+    return Result(time)
+        .metric("open", openTime / iterations, "ms")
+        .metric("leaves loaded", leavesLoaded / iterations)
+        .metric("paged in", pagedIn / iterations / (1024.0 * 1024.0), "MB")
+        .metric("throughput", double(queries) / (time * 1000.0), "M queries/s");
+}
+
+Result getValuePattern(const Context& ctx, Pattern pattern, bool delayed)
+{
+    std::vector<Coord> ijks;
+    addPatternIJKs(ctx.tree(), pattern, ctx.parser.misses(), ijks);
+    if (ijks.empty())   return Result::skip("the grid has no active voxels");
+
+    return delayedLoad(ctx.vdb, ctx.grid, delayed, ijks.size(), ctx.iterations, [&](const FloatTree& tree) {
+        auto getValues = [&](const tbb::blocked_range<size_t>& range) {
+            float total = 0.0f;
+            tree::ValueAccessor<const FloatTree> valueAccessor(tree);
+            for (size_t n = range.begin(); n < range.end(); n++) {
+                total += valueAccessor.getValue(ijks[n]);
+            }
+            if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+        };
+
+        if (ctx.threaded)   tbb::parallel_for(tbb::blocked_range<size_t>(0, ijks.size(), 1024), getValues);
+        else                getValues(tbb::blocked_range<size_t>(0, ijks.size()));
+    });
+}
+
+Result getValueLeafIterator(const Context& ctx, bool delayed)
+{
+    const size_t queries = size_t(ctx.tree().activeVoxelCount());
+
+    return delayedLoad(ctx.vdb, ctx.grid, delayed, queries, ctx.iterations, [&](const FloatTree& tree) {
+        tree::LeafManager<const FloatTree> leafManager(tree);
+        auto getValues = [&](const tree::LeafManager<const FloatTree>::LeafRange& range) {
+            float total = 0.0f;
+            for (auto leaf = range.begin(); leaf; ++leaf) {
+                for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                    total += iter.getValue();
+                }
+            }
+            if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+        };
+
+        if (ctx.threaded)   tbb::parallel_for(leafManager.leafRange(), getValues);
+        else                getValues(leafManager.leafRange());
+    });
+}
+
+// time the first access to each leaf in leaf order, which is when its buffer is loaded
+
+Result leafLoadLatency(const std::string& filepath, const std::string& gridName, int iterations)
+{
+    using Clock = std::chrono::steady_clock;
+
+    double time = 0.0f;
+    double openTime = 0.0f;
+    std::vector<double> latencies;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictFile(filepath);
+
+        FloatTree::Ptr tree = openTree(filepath, gridName, /*delayed=*/true, openTime);
+        if (!tree)  return Result::skip("the grid is not a float grid");
+
+        evictCache();
+
+        float total = 0.0f;
+        for (auto leaf = tree->cbeginLeaf(); leaf; ++leaf) {
+            if (!leaf->buffer().isOutOfCore())  continue;
+            const auto start = Clock::now();
+            total += leaf->buffer().data()[0];
+            const std::chrono::duration<double, std::micro> duration = Clock::now() - start;
+            latencies.push_back(duration.count());
+            time += duration.count() / 1000.0;
+        }
+        if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+    }
+
+    time /= iterations;
+
+    if (latencies.empty())  return Result::skip("delayed loading is disabled or the VDB has no leaves");
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double fraction) {
+        return latencies[std::min(latencies.size() - 1, size_t(fraction * double(latencies.size())))];
+    };
+
+    return Result(time)
+        .metric("open", openTime / iterations, "ms")
+        .metric("leaves", double(latencies.size()) / iterations)
+        .metric("p50", percentile(0.5), "us")
+        .metric("p99", percentile(0.99), "us")
+        .metric("max", latencies.back(), "us");
+}
+
+std::vector<Case> delayedLoadCases()
+{
+    std::vector<Case> cases;
+    cases.push_back({ "Cloud Delayed Load Leaf Latency", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return leafLoadLatency(ctx.vdb, ctx.grid, ctx.iterations); } });
+    for (bool delayed : { true, false }) {
+        const std::string prefix = delayed ? "Cloud Delayed Load " : "Cloud Eager Load ";
+        cases.push_back({ prefix + "Leaf Iterator", Case::Asset | Case::Serial | Case::Threaded,
+            [=](const Context& ctx) { return getValueLeafIterator(ctx, delayed); } });
+        for (Pattern pattern : { Pattern::Sequential, Pattern::Interleaved, Pattern::Random,
+                Pattern::Morton, Pattern::Hilbert, Pattern::RayWalk, Pattern::StencilWalk }) {
+            cases.push_back({ prefix + patternName(pattern) + " Accessor", Case::Asset | Case::Serial | Case::Threaded,
+                [=](const Context& ctx) { return getValuePattern(ctx, pattern, delayed); } });
+        }
+    }
+    return cases;
+}
+
+const bool registered = registerCases("delayed_load", delayedLoadCases());
+
+} // namespace
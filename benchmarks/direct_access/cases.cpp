@@ -0,0 +1,106 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include "../bench.h"
+#include "../patterns.h"
+
+using namespace openvdb;
+
+namespace {
+
+double getValueDirect(const FloatTree& refTree, const std::vector<Coord>& ijks, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0;
+
+    std::unique_ptr<FloatTree> copy;
+
+    for (int i = 0; i < iterations; i++) {
+
+        const FloatTree& tree = remapTree(refTree, copy);
+        const auto& root = tree.root();
+
+        evictCache();
+
+        timer.start();
+
+        for (const auto& ijk : ijks) {
+            total += root.getValue(ijk);
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+double getValueAccessor(const FloatTree& refTree, const std::vector<Coord>& ijks, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0;
+
+    std::unique_ptr<FloatTree> copy;
+
+    for (int i = 0; i < iterations; i++) {
+
+        const FloatTree& tree = remapTree(refTree, copy);
+
+        evictCache();
+
+        timer.start();
+
+        tree::ValueAccessor<const FloatTree> valueAccessor(tree);
+
+        for (const auto& ijk : ijks) {
+            total += valueAccessor.getValue(ijk);
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+Result getValuePattern(const FloatTree& tree, Pattern pattern, double missFraction, bool accessor, int iterations)
+{
+    std::vector<Coord> ijks;
+    addPatternIJKs(tree, pattern, missFraction, ijks);
+    if (ijks.empty())   return Result::skip("the grid has no active voxels");
+
+    Result result(accessor ? getValueAccessor(tree, ijks, iterations) : getValueDirect(tree, ijks, iterations));
+
+    const std::vector<double> locality = patternLocality(ijks);
+    return result
+        .metric("queries", double(ijks.size()))
+        .metric("miss fraction", missFraction)
+        .metric("same leaf", locality[0])
+        .metric("same lower internal", locality[1])
+        .metric("same upper internal", locality[2]);
+}
+
+std::vector<Case> patternCases()
+{
+    std::vector<Case> cases;
+    for (Pattern pattern : { Pattern::Sequential, Pattern::Interleaved, Pattern::Random,
+            Pattern::Morton, Pattern::Hilbert, Pattern::RayWalk, Pattern::StencilWalk }) {
+        for (bool accessor : { false, true }) {
+            cases.push_back({ std::string("Cloud Get Value ") + patternName(pattern) + (accessor ? " Accessor" : " Direct"),
+                Case::Asset | Case::Serial,
+                [=](const Context& ctx) {
+                    return getValuePattern(ctx.tree(), pattern, ctx.parser.misses(), accessor, ctx.iterations);
+                } });
+        }
+    }
+    return cases;
+}
+
+const bool registered = registerCases("direct_access", patternCases());
+
+} // namespace
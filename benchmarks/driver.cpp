@@ -0,0 +1,393 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <regex>
+
+#include "allocator.h"
+#include "asset.h"
+#include "bench.h"
+#include "trace.h"
+
+using namespace openvdb;
+
+namespace {
+
+struct Run
+{
+    const Case* benchmark;
+    std::string name;
+    bool threaded;
+    int threads;
+
+    std::string fullName() const { return benchmark->suite + "/" + name; }
+};
+
+struct Summary
+{
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    Result result;      // metrics are averaged across repetitions
+};
+
+std::string escape(const std::string& str)
+{
+    std::string result;
+    for (char c : str) {
+        if (c == '"' || c == '\\')  result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+class Reporter
+{
+public:
+    Reporter(const std::string& format, int repetitions):
+        mFormat(format), mRepetitions(repetitions) { }
+
+    void begin()
+    {
+        if (mFormat == "csv") {
+            std::cout << "vdb,grid,suite,name,threads,repetitions,metric,value,units\n";
+        } else if (mFormat == "json") {
+            std::cout << "[";
+        }
+    }
+
+    // the shape of the asset that the following benchmarks run on
+
+    void asset(const Asset& asset)
+    {
+        mVdb = asset.filepath;
+        mGrid = asset.grid;
+
+        const TreeStats& stats = asset.stats;
+        const std::vector<Metric> metrics = {
+            { "active voxels", double(stats.activeVoxelCount), "" },
+            { "leaves", double(stats.leafCount), "" },
+            { "mean leaf fill", stats.meanFill, "" },
+            { "min leaf fill", stats.minFill, "" },
+            { "max leaf fill", stats.maxFill, "" },
+            { "root children", double(stats.rootChildCount), "" },
+            { "active tiles", double(stats.activeTileCount), "" },
+            { "tile voxel ratio", stats.tileVoxelRatio, "" }
+        };
+
+        if (mFormat == "text") {
+            std::cerr << mVdb << " (" << mGrid << ")";
+            for (size_t i = 0; i < metrics.size(); i++) {
+                std::cerr << (i == 0 ? ": " : ", ") << metrics[i].name << " " << metrics[i].value;
+            }
+            std::cerr << "\n";
+        } else if (mFormat == "csv") {
+            const std::string prefix = this->csvPrefix(true) + "\"asset\",\"stats\",0,0,";
+            for (const Metric& metric : metrics) {
+                std::cout << prefix << "\"" << escape(metric.name) << "\"," << metric.value << ",\"\"\n";
+            }
+        } else if (mFormat == "json") {
+            std::cout << (mCount++ > 0 ? ",\n" : "\n") << "  {" << this->jsonPrefix(true) <<
+                "\"suite\": \"asset\", \"name\": \"stats\", \"metrics\": [";
+            this->jsonMetrics(metrics);
+            std::cout << "]}";
+        }
+    }
+
+    void start(const Run& run)
+    {
+        if (mFormat == "text")  std::cerr << run.name << " ...";
+    }
+
+    void finish(const Run& run, const Summary& summary)
+    {
+        if (mFormat == "text")          this->text(summary);
+        else if (mFormat == "csv")      this->csv(run, summary);
+        else if (mFormat == "json")     this->json(run, summary);
+    }
+
+    void end()
+    {
+        if (mFormat == "json")  std::cout << (mCount > 0 ? "\n]\n" : "]\n");
+    }
+
+private:
+    void text(const Summary& summary)
+    {
+        if (!summary.result.skipped.empty()) {
+            std::cerr << " skipped (" << summary.result.skipped << ")\n";
+            return;
+        }
+
+        std::ostringstream tail;
+        if (mRepetitions > 1) {
+            util::printTime(tail, summary.min, " [min ", "", 4, 3, 1);
+            util::printTime(tail, summary.max, ", max ", "]", 4, 3, 1);
+        }
+        for (size_t i = 0; i < summary.result.metrics.size(); i++) {
+            const Metric& metric = summary.result.metrics[i];
+            tail << (i == 0 ? " (" : ", ") << metric.name << " " << metric.value;
+            if (!metric.units.empty())  tail << " " << metric.units;
+        }
+        if (!summary.result.metrics.empty())    tail << ")";
+        tail << "\n";
+
+        util::printTime(std::cerr, summary.mean, " completed in ", tail.str(), 4, 3, 1);
+    }
+
+    void csv(const Run& run, const Summary& summary)
+    {
+        if (!summary.result.skipped.empty())    return;
+
+        const std::string prefix = this->csvPrefix(run.benchmark->flags & Case::Asset) +
+            "\"" + escape(run.benchmark->suite) + "\",\"" + escape(run.name) + "\"," +
+            std::to_string(run.threads) + "," + std::to_string(mRepetitions) + ",";
+
+        std::cout << prefix << "\"time\"," << summary.mean << ",\"ms\"\n";
+        std::cout << prefix << "\"time min\"," << summary.min << ",\"ms\"\n";
+        std::cout << prefix << "\"time max\"," << summary.max << ",\"ms\"\n";
+        for (const Metric& metric : summary.result.metrics) {
+            std::cout << prefix << "\"" << escape(metric.name) << "\"," << metric.value <<
+                ",\"" << escape(metric.units) << "\"\n";
+        }
+    }
+
+    void json(const Run& run, const Summary& summary)
+    {
+        std::cout << (mCount++ > 0 ? ",\n" : "\n") << "  {" << this->jsonPrefix(run.benchmark->flags & Case::Asset) <<
+            "\"suite\": \"" << escape(run.benchmark->suite) <<
+            "\", \"name\": \"" << escape(run.name) << "\", \"threads\": " << run.threads <<
+            ", \"repetitions\": " << mRepetitions;
+        if (!summary.result.skipped.empty()) {
+            std::cout << ", \"skipped\": \"" << escape(summary.result.skipped) << "\"}";
+            return;
+        }
+        std::cout << ", \"time\": {\"mean\": " << summary.mean << ", \"min\": " << summary.min <<
+            ", \"max\": " << summary.max << ", \"units\": \"ms\"}, \"metrics\": [";
+        this->jsonMetrics(summary.result.metrics);
+        std::cout << "]}";
+    }
+
+    void jsonMetrics(const std::vector<Metric>& metrics)
+    {
+        for (size_t i = 0; i < metrics.size(); i++) {
+            const Metric& metric = metrics[i];
+            std::cout << (i == 0 ? "" : ", ") << "{\"name\": \"" << escape(metric.name) << "\", \"value\": " <<
+                metric.value << ", \"units\": \"" << escape(metric.units) << "\"}";
+        }
+    }
+
+    // benchmarks that do not use an asset are reported with an empty VDB and grid
+
+    std::string csvPrefix(bool usesAsset) const
+    {
+        return "\"" + escape(usesAsset ? mVdb : "") + "\",\"" + escape(usesAsset ? mGrid : "") + "\",";
+    }
+
+    std::string jsonPrefix(bool usesAsset) const
+    {
+        return "\"vdb\": \"" + escape(usesAsset ? mVdb : "") + "\", \"grid\": \"" + escape(usesAsset ? mGrid : "") + "\", ";
+    }
+
+    std::string mFormat;
+    int mRepetitions;
+    int mCount = 0;
+    std::string mVdb;
+    std::string mGrid;
+};
+
+// expand the registered benchmarks into the serial and per-thread-count runs that match the filter
+
+std::vector<Run> selectRuns(const OptParse& parser)
+{
+    std::vector<Case>& cases = registry();
+    std::stable_sort(cases.begin(), cases.end(),
+        [](const Case& a, const Case& b) { return a.suite < b.suite; });
+
+    std::regex filter;
+    try {
+        filter = std::regex(parser.filter());
+    } catch (const std::regex_error& e) {
+        std::cerr << "invalid filter " << parser.filter() << " (" << e.what() << ")\n";
+        parser.usage(1);
+    }
+
+    std::vector<Run> runs;
+
+    auto add = [&](const Case& benchmark, const std::string& name, bool threaded, int threads) {
+        Run run{&benchmark, name, threaded, threads};
+        if (std::regex_search(run.fullName(), filter))  runs.push_back(run);
+    };
+
+    for (const auto& benchmark : cases) {
+        if ((benchmark.flags & Case::Serial) || !(benchmark.flags & Case::Threaded)) {
+            add(benchmark, benchmark.name, false, 1);
+        }
+        if (benchmark.flags & Case::Threaded) {
+            for (int n = 1; n <= parser.cpus(); n *= 2) {
+                add(benchmark, benchmark.name + " Thread" + std::to_string(n), true, n);
+            }
+        }
+    }
+
+    return runs;
+}
+
+Result execute(const Run& run, const Context& ctx, bool cold)
+{
+    cacheControl().cold = cold;
+
+    // serial runs are pinned to a single thread too, so that OpenVDB methods that are threaded
+    // internally do not run on every core under a serial label
+
+    tbb::global_control global_control(tbb::global_control::max_allowed_parallelism, run.threaded ? run.threads : 1);
+    return run.benchmark->run(ctx);
+}
+
+// with both cache modes the warm result is reported with the cold time appended to its metrics
+
+Result execute(const Run& run, const Context& ctx, const std::string& cache)
+{
+    if (cache != "both")    return execute(run, ctx, cache == "cold");
+
+    Result result = execute(run, ctx, false);
+    if (!result.skipped.empty())    return result;
+
+    const Result cold = execute(run, ctx, true);
+    return result
+        .metric("cold", cold.time, "ms")
+        .metric("cold/warm", cold.time / result.time);
+}
+
+Summary execute(const Run& run, const Context& ctx, const std::string& cache, int repetitions)
+{
+    Summary summary;
+
+    for (int r = 0; r < repetitions; r++) {
+
+        Result result = execute(run, ctx, cache);
+
+        if (!result.skipped.empty()) {
+            summary.result = result;
+            return summary;
+        }
+
+        summary.mean += result.time;
+        summary.min = r == 0 ? result.time : std::min(summary.min, result.time);
+        summary.max = r == 0 ? result.time : std::max(summary.max, result.time);
+
+        if (r == 0) {
+            summary.result = result;
+        } else {
+            for (size_t i = 0; i < std::min(result.metrics.size(), summary.result.metrics.size()); i++) {
+                summary.result.metrics[i].value += result.metrics[i].value;
+            }
+        }
+    }
+
+    summary.mean /= repetitions;
+    summary.result.time = summary.mean;
+    for (Metric& metric : summary.result.metrics) {
+        metric.value /= repetitions;
+    }
+
+    return summary;
+}
+
+} // namespace
+
+
+int
+main(int argc, char *argv[])
+{
+    openvdb::initialize();
+
+    OptParse parser(argc, argv);
+    int iterations = parser.iterations();
+    int repetitions = parser.repetitions();
+    int cpus = parser.cpus();
+
+    std::vector<Run> runs = selectRuns(parser);
+
+    if (parser.has("-list")) {
+        for (const auto& run : runs) {
+            std::cout << run.fullName() << "\n";
+        }
+        return 0;
+    }
+
+    std::string cache = parser.cache();
+    cacheControl().remap = parser.has("-remap");
+
+    Reporter reporter(parser.format(), repetitions);
+
+    // the nodes of the loaded assets are allocated from the pool when requested
+
+    const bool usePool = parser.allocator() == "pool";
+    if (usePool) {
+        pool::registerTree<FloatTree>();
+        if (!pool::initialize(parser.has("-hugepages"))) {
+            std::cerr << "unable to reserve the address range of the pool allocator\n";
+            return 1;
+        }
+        pool::setAssetPool(true);
+    }
+
+    // every benchmark that uses an asset runs once per selected grid of every VDB
+
+    std::vector<std::pair<std::string, std::string>> sources;
+    if (std::any_of(runs.begin(), runs.end(),
+            [](const Run& run) { return run.benchmark->flags & Case::Asset; })) {
+        for (const auto& filepath : vdbFiles(parser.vdb())) {
+            const std::vector<std::string> grids = vdbGridNames(filepath, parser.grid());
+            if (grids.empty())  std::cerr << "skipping " << filepath << ", no matching float grids\n";
+            for (const auto& grid : grids) {
+                sources.emplace_back(filepath, grid);
+            }
+        }
+        if (sources.empty()) {
+            std::cerr << "no matching float grids in " << parser.vdb() << "\n";
+            return 1;
+        }
+    }
+
+    if (parser.has("-trace"))   tracer().enable();
+
+    reporter.begin();
+
+    for (size_t i = 0; i < std::max(sources.size(), size_t(1)); i++) {
+
+        // load each asset a single time and share it across all of the selected benchmarks
+
+        Asset asset;
+        if (i < sources.size()) {
+            {
+                pool::Scope scope(pool::assetPool());
+                asset = openVDBAsset(sources[i].first, sources[i].second, parser.get("-snapshots", ""));
+            }
+            reporter.asset(asset);
+        }
+
+        for (const auto& run : runs) {
+            const bool usesAsset = run.benchmark->flags & Case::Asset;
+            if (!usesAsset && i > 0)    continue;
+            Context ctx{parser, usesAsset ? asset.tree.get() : nullptr, usesAsset ? asset.filepath : "",
+                usesAsset ? asset.grid : "", iterations, cpus, run.threaded, run.threads};
+            reporter.start(run);
+            if (tracer().enabled()) {
+                tracer().beginProcess(usesAsset && sources.size() > 1 ?
+                    run.fullName() + " [" + asset.filepath + " " + asset.grid + "]" : run.fullName());
+            }
+            reporter.finish(run, execute(run, ctx, cache, repetitions));
+        }
+    }
+
+    reporter.end();
+
+    if (tracer().enabled())     tracer().write(parser.get("-trace", ""));
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/parallel_for.h>
+
+#include <memory>
+#include <vector>
+
+using namespace openvdb;
+
+// flatten the active voxels of a tree into arrays in leaf order, the active voxels of each leaf
+// are counted in parallel, an exclusive prefix sum of the counts gives the offset at which each
+// leaf writes its voxels so the arrays can be preallocated and filled in parallel without locks
+
+// a structure-of-arrays layout of coordinates and values, the arrays are left uninitialized
+// when allocated so that they are first touched by the threads that fill them
+
+struct VoxelArrays
+{
+    size_t size = 0;
+    std::unique_ptr<Int32[]> x, y, z;
+    std::unique_ptr<float[]> values;
+
+    void allocate(size_t size_)
+    {
+        if (size_ > size || !x) {
+            x.reset(new Int32[size_]);
+            y.reset(new Int32[size_]);
+            z.reset(new Int32[size_]);
+            values.reset(new float[size_]);
+        }
+        size = size_;
+    }
+};
+
+// an array-of-structures layout of coordinates with the same layout as an array of Coord,
+// which is left uninitialized like VoxelArrays, as a Coord array would be zeroed when allocated
+
+struct VoxelCoords
+{
+    size_t size = 0;
+    std::unique_ptr<Int32[]> xyz;
+
+    void allocate(size_t size_)
+    {
+        if (size_ > size || !xyz)   xyz.reset(new Int32[size_ * 3]);
+        size = size_;
+    }
+
+    Coord operator[](size_t i) const { return Coord(xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2]); }
+};
+
+// returns one more offset than there are leaves, the last offset is the total voxel count
+
+inline std::vector<size_t> activeVoxelOffsets(const tree::LeafManager<const FloatTree>& leafManager, bool threaded)
+{
+    std::vector<size_t> offsets(leafManager.leafCount() + 1, 0);
+
+    auto count = [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t n = range.begin(); n < range.end(); n++) {
+            offsets[n + 1] = size_t(leafManager.leaf(n).onVoxelCount());
+        }
+    };
+
+    if (threaded)   tbb::parallel_for(tbb::blocked_range<size_t>(0, leafManager.leafCount()), count);
+    else            count(tbb::blocked_range<size_t>(0, leafManager.leafCount()));
+
+    // the scan is over leaves rather than voxels so it is cheap enough to run serially
+
+    for (size_t n = 1; n < offsets.size(); n++) {
+        offsets[n] += offsets[n - 1];
+    }
+
+    return offsets;
+}
+
+// calls op(i, iter) for every active voxel where i is the index of the voxel in leaf order
+
+template <typename OpT>
+inline void foreachActiveVoxel(const tree::LeafManager<const FloatTree>& leafManager,
+    const std::vector<size_t>& offsets, bool threaded, const OpT& op)
+{
+    auto fill = [&](const tbb::blocked_range<size_t>& range) {
+        for (size_t n = range.begin(); n < range.end(); n++) {
+            size_t i = offsets[n];
+            for (auto iter = leafManager.leaf(n).cbeginValueOn(); iter; ++iter) {
+                op(i++, iter);
+            }
+        }
+    };
+
+    if (threaded)   tbb::parallel_for(tbb::blocked_range<size_t>(0, leafManager.leafCount()), fill);
+    else            fill(tbb::blocked_range<size_t>(0, leafManager.leafCount()));
+}
+
+inline void extractActiveVoxels(const FloatTree& tree, VoxelArrays& arrays, bool threaded = true)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+    const std::vector<size_t> offsets = activeVoxelOffsets(leafManager, threaded);
+    arrays.allocate(offsets.back());
+
+    foreachActiveVoxel(leafManager, offsets, threaded,
+        [&](size_t i, const FloatTree::LeafNodeType::ValueOnCIter& iter) {
+            const Coord ijk = iter.getCoord();
+            arrays.x[i] = ijk.x();
+            arrays.y[i] = ijk.y();
+            arrays.z[i] = ijk.z();
+            arrays.values[i] = iter.getValue();
+        });
+}
+
+inline void extractActiveVoxelIJKs(const FloatTree& tree, VoxelCoords& coords, bool threaded = true)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+    const std::vector<size_t> offsets = activeVoxelOffsets(leafManager, threaded);
+    coords.allocate(offsets.back());
+
+    foreachActiveVoxel(leafManager, offsets, threaded,
+        [&](size_t i, const FloatTree::LeafNodeType::ValueOnCIter& iter) {
+            const Coord ijk = iter.getCoord();
+            coords.xyz[i * 3] = ijk.x();
+            coords.xyz[i * 3 + 1] = ijk.y();
+            coords.xyz[i * 3 + 2] = ijk.z();
+        });
+}
+
+// the parallel equivalent of addSequentialVoxelIJKs, which produces the same order, for the
+// callers that need a vector of coordinates, which is zeroed serially when it is resized
+
+inline void addActiveVoxelIJKs(const FloatTree& tree, std::vector<Coord>& ijks, bool threaded = true)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+    const std::vector<size_t> offsets = activeVoxelOffsets(leafManager, threaded);
+    ijks.resize(offsets.back());
+
+    foreachActiveVoxel(leafManager, offsets, threaded,
+        [&](size_t i, const FloatTree::LeafNodeType::ValueOnCIter& iter) { ijks[i] = iter.getCoord(); });
+}
@@ -0,0 +1,99 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include "../bench.h"
+#include "../extract.h"
+#include "../patterns.h"
+
+using namespace openvdb;
+
+namespace {
+
+// the output arrays are created within the timer and destroyed outside of it, so that
+// every iteration pays for growing or allocating the arrays
+
+template <typename OutputT, typename ExtractOp>
+Result extract(const ExtractOp& op, size_t bytesPerVoxel, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    size_t count = 0;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        std::unique_ptr<OutputT> output(new OutputT);
+        count = op(*output);
+
+        time += timer.milliseconds();
+    }
+
+    time /= iterations;
+
+    return Result(time)
+        .metric("voxels", double(count) / 1e6, "M")
+        .metric("bandwidth", double(count * bytesPerVoxel) / (time * 1e6), "GB/s");
+}
+
+struct VoxelVectors
+{
+    std::vector<Int32> x, y, z;
+    std::vector<float> values;
+};
+
+Result extractCoordinatesEmplaceBack(const FloatTree& tree, int iterations)
+{
+    return extract<std::vector<Coord>>([&](std::vector<Coord>& ijks) {
+        addSequentialVoxelIJKs(tree, ijks);
+        return ijks.size();
+    }, sizeof(Coord), iterations);
+}
+
+Result extractCoordinatesPrefixSum(const FloatTree& tree, bool threaded, int iterations)
+{
+    return extract<VoxelCoords>([&](VoxelCoords& coords) {
+        extractActiveVoxelIJKs(tree, coords, threaded);
+        return coords.size;
+    }, sizeof(Coord), iterations);
+}
+
+Result extractArraysEmplaceBack(const FloatTree& tree, int iterations)
+{
+    return extract<VoxelVectors>([&](VoxelVectors& arrays) {
+        for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+            for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                const Coord ijk = iter.getCoord();
+                arrays.x.emplace_back(ijk.x());
+                arrays.y.emplace_back(ijk.y());
+                arrays.z.emplace_back(ijk.z());
+                arrays.values.emplace_back(iter.getValue());
+            }
+        }
+        return arrays.values.size();
+    }, sizeof(Coord) + sizeof(float), iterations);
+}
+
+Result extractArraysPrefixSum(const FloatTree& tree, bool threaded, int iterations)
+{
+    return extract<VoxelArrays>([&](VoxelArrays& arrays) {
+        extractActiveVoxels(tree, arrays, threaded);
+        return arrays.size;
+    }, sizeof(Coord) + sizeof(float), iterations);
+}
+
+const bool registered = registerCases("extract", {
+    { "Cloud Extract Coordinates Emplace Back", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return extractCoordinatesEmplaceBack(ctx.tree(), ctx.iterations); } },
+    { "Cloud Extract Coordinates Prefix Sum", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return extractCoordinatesPrefixSum(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Extract Coordinates And Values Emplace Back", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return extractArraysEmplaceBack(ctx.tree(), ctx.iterations); } },
+    { "Cloud Extract Coordinates And Values Prefix Sum", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return extractArraysPrefixSum(ctx.tree(), ctx.threaded, ctx.iterations); } },
+});
+
+} // namespace
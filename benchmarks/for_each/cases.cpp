@@ -0,0 +1,333 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tools/ValueTransformer.h>
+#include <openvdb/tree/LeafManager.h>
+#include <openvdb/tree/NodeManager.h>
+
+#include <tbb/parallel_for.h>
+
+#include "../allocator.h"
+#include "../bench.h"
+#include "../trace.h"
+
+using namespace openvdb;
+
+namespace {
+
+struct DoubleOp
+{
+    template <typename T>
+    bool operator()(T&, size_t = 0) const { return true; }
+
+    bool operator()(FloatTree::LeafNodeType& leaf, size_t idx = 0) const
+    {
+        for (auto iter = leaf.beginValueOn(); iter; ++iter) {
+            iter.setValue(iter.getValue() * 2);
+        }
+        return true;
+    }
+};
+
+// the LeafManager foreach with one span per leaf range handed to a thread
+
+void traceLeafManager(tree::LeafManager<FloatTree>& leafManager, const DoubleOp& op, bool threaded)
+{
+    using LeafRange = tree::LeafManager<FloatTree>::LeafRange;
+
+    auto body = [&](const LeafRange& range) {
+        const size_t first = range.begin().pos();
+        traceChunk("Leaf", first, first + range.size() - 1, [&]() {
+            for (auto leaf = range.begin(); leaf; ++leaf) {
+                op(*leaf, leaf.pos());
+            }
+        });
+    };
+
+    if (leafManager.leafCount() == 0)   return;
+    if (threaded)   tbb::parallel_for(leafManager.leafRange(/*grainSize=*/1), body);
+    else            body(leafManager.leafRange());
+}
+
+// the NodeManager neither exposes its node ranges nor passes node indices to the operator, so
+// the traced variant mirrors foreachTopDown, the root followed by one parallel_for per level
+// with the same grain size, with one span per node range handed to a thread
+
+void traceNodeManager(FloatTree& tree, const DoubleOp& op, bool threaded)
+{
+    using LeafT = FloatTree::LeafNodeType;
+    using UpperT = FloatTree::RootNodeType::ChildNodeType;
+    using LowerT = UpperT::ChildNodeType;
+
+    std::vector<UpperT*> upperNodes;
+    std::vector<LowerT*> lowerNodes;
+    std::vector<LeafT*> leafNodes;
+    tree.getNodes(upperNodes);
+    tree.getNodes(lowerNodes);
+    tree.getNodes(leafNodes);
+
+    op(tree.root());
+    traceForeach(upperNodes, op, threaded, /*grainSize=*/1);
+    traceForeach(lowerNodes, op, threaded, /*grainSize=*/1);
+    traceForeach(leafNodes, op, threaded, /*grainSize=*/1);
+}
+
+// the working copy of the asset comes from the same allocator as the asset itself
+
+FloatTree copyTree(const FloatTree& refTree)
+{
+    FloatTree tree = [&]() {
+        pool::Scope scope(pool::assetPool());
+        return FloatTree(refTree);
+    }();
+
+    // warm up
+
+    float total = 0.0f;
+    for (auto iter = tree.cbeginValueOn(); iter; ++iter) {
+        total += iter.getValue();
+    }
+    if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+
+    return tree;
+}
+
+double setValueSequentialLeaf(const FloatTree& refTree, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        for (auto leaf = tree.beginLeaf(); leaf; ++leaf) {
+            for (auto iter = leaf->beginValueOn(); iter; ++iter) {
+                iter.setValue(iter.getValue() * 2);
+            }
+        }
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueSequentialValue(const FloatTree& refTree, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        for (auto iter = tree.beginValueOn(); iter; ++iter) {
+            iter.setValue(iter.getValue() * 2);
+        }
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueForeachValue(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    auto op = [&](const auto& iter) {
+        iter.setValue(iter.getValue() * 2);
+    };
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        tools::foreach(tree.beginValueOn(), op, threaded);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueForeachLeaf(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    auto op = [&](const auto& leaf) {
+        for (auto iter = leaf->beginValueOn(); iter; ++iter) {
+            iter.setValue(iter.getValue() * 2);
+        }
+    };
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        tools::foreach(tree.beginLeaf(), op, threaded);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueForeachIterRange(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    using RangeT = tree::IteratorRange<FloatTree::ValueOnIter>;
+
+    auto op = [&](const RangeT& range) {
+        for (RangeT iter(range); iter; ++iter) {
+            iter.iterator().setValue(iter.iterator().getValue() * 2);
+        }
+    };
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        RangeT iterRange(tree.beginValueOn());
+
+        if (threaded)   tbb::parallel_for(iterRange, op);
+        else            op(iterRange);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueLeafManager(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        TraceScope scope("LeafManager foreach");
+
+        tree::LeafManager<FloatTree> leafManager(tree);
+        DoubleOp op;
+        if (tracer().enabled())     traceLeafManager(leafManager, op, threaded);
+        else                        leafManager.foreach(op, threaded, /*grainSize=*/1);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueNodeManager(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        TraceScope scope("NodeManager foreachTopDown");
+
+        DoubleOp op;
+        if (tracer().enabled()) {
+            traceNodeManager(tree, op, threaded);
+        } else {
+            tree::NodeManager<FloatTree> nodeManager(tree);
+            nodeManager.foreachTopDown(op, threaded, /*grainSize=*/1);
+        }
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+double setValueDynamicNodeManager(const FloatTree& refTree, bool threaded, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    FloatTree tree = copyTree(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        TraceScope scope("DynamicNodeManager foreachTopDown");
+
+        tree::DynamicNodeManager<FloatTree> nodeManager(tree);
+        DoubleOp op;
+        if (tracer().enabled())     nodeManager.foreachTopDown(TraceOp<DoubleOp>(op), threaded, /*grainSize=*/1);
+        else                        nodeManager.foreachTopDown(op, threaded, /*grainSize=*/1);
+
+        time += timer.milliseconds();
+    }
+
+    return time/iterations;
+}
+
+const bool registered = registerCases("for_each", {
+    { "Cloud Set Value Sequential Value Iterator", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return setValueSequentialValue(ctx.tree(), ctx.iterations); } },
+    { "Cloud Set Value Sequential Leaf Iterator", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return setValueSequentialLeaf(ctx.tree(), ctx.iterations); } },
+    { "Cloud Set Value Foreach Value", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueForeachValue(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Set Value Foreach Leaf", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueForeachLeaf(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Set Value Foreach Iter Range", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueForeachIterRange(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Set Value LeafManager", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueLeafManager(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Set Value NodeManager", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueNodeManager(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    { "Cloud Set Value DynamicNodeManager", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return setValueDynamicNodeManager(ctx.tree(), ctx.threaded, ctx.iterations); } },
+});
+
+} // namespace
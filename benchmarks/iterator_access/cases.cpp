@@ -2,19 +2,26 @@
 #include <openvdb/openvdb.h>
 #include <openvdb/util/CpuTimer.h>
 
-#include "../asset.h"
-#include "../parse.h"
+#include "../bench.h"
 
 using namespace openvdb;
 
-void getValueSequentialLeaf(const FloatTree& tree, int iterations)
+namespace {
+
+double getValueSequentialLeaf(const FloatTree& refTree, int iterations)
 {
     util::CpuTimer timer;
     double time = 0.0f;
     float total = 0.0f;
 
+    std::unique_ptr<FloatTree> copy;
+
     for (int i = 0; i < iterations; i++) {
 
+        const FloatTree& tree = remapTree(refTree, copy);
+
+        evictCache();
+
         timer.start();
 
         for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
@@ -28,17 +35,23 @@ void getValueSequentialLeaf(const FloatTree& tree, int iterations)
         if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
     }
 
-    util::printTime(std::cerr, time/iterations, " completed in ", "\n", 4, 3, 1);
+    return time/iterations;
 }
 
-void getValueSequentialChild(const FloatTree& tree, int iterations)
+double getValueSequentialChild(const FloatTree& refTree, int iterations)
 {
     util::CpuTimer timer;
     double time = 0.0f;
     float total = 0.0f;
 
+    std::unique_ptr<FloatTree> copy;
+
     for (int i = 0; i < iterations; i++) {
 
+        const FloatTree& tree = remapTree(refTree, copy);
+
+        evictCache();
+
         timer.start();
 
         for (auto iter1 = tree.cbeginRootChildren(); iter1; ++iter1) {
@@ -56,17 +69,23 @@ void getValueSequentialChild(const FloatTree& tree, int iterations)
         if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
     }
 
-    util::printTime(std::cerr, time/iterations, " completed in ", "\n", 4, 3, 1);
+    return time/iterations;
 }
 
-void getValueSequentialValue(const FloatTree& tree, int iterations)
+double getValueSequentialValue(const FloatTree& refTree, int iterations)
 {
     util::CpuTimer timer;
     double time = 0.0f;
     float total = 0.0f;
 
+    std::unique_ptr<FloatTree> copy;
+
     for (int i = 0; i < iterations; i++) {
 
+        const FloatTree& tree = remapTree(refTree, copy);
+
+        evictCache();
+
         timer.start();
 
         for (auto iter = tree.cbeginValueOn(); iter; ++iter) {
@@ -78,28 +97,16 @@ void getValueSequentialValue(const FloatTree& tree, int iterations)
         if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
     }
 
-    util::printTime(std::cerr, time/iterations, " completed in ", "\n", 4, 3, 1);
+    return time/iterations;
 }
 
+const bool registered = registerCases("iterator_access", {
+    { "Cloud Get Value Sequential Leaf Iterator", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return getValueSequentialLeaf(ctx.tree(), ctx.iterations); } },
+    { "Cloud Get Value Sequential Hierarchy Iterator", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return getValueSequentialChild(ctx.tree(), ctx.iterations); } },
+    { "Cloud Get Value Sequential Voxel Iterator", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return getValueSequentialValue(ctx.tree(), ctx.iterations); } },
+});
 
-int
-main(int argc, char *argv[])
-{
-    openvdb::initialize();
-
-    OptParse parser(argc, argv, /*vdbArg=*/true, /*cpusArg=*/false);
-    int iterations = parser.iterations();
-
-    FloatTree tree = openVDBAsset(parser.vdb());
-
-    std::cerr << "Cloud Get Value Sequential Leaf Iterator ...";
-    getValueSequentialLeaf(tree, iterations);
-
-    std::cerr << "Cloud Get Value Sequential Hierarchy Iterator ...";
-    getValueSequentialChild(tree, iterations);
-
-    std::cerr << "Cloud Get Value Sequential Voxel Iterator ...";
-    getValueSequentialValue(tree, iterations);
-
-    return 0;
-}
+} // namespace
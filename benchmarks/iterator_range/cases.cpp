@@ -0,0 +1,233 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+struct Task
+{
+    size_t work;    // number of items processed by this task
+    int depth;      // number of times the range was split before reaching this task
+    float sum;      // result of the traversal, prevents optimization
+};
+
+using TaskList = tbb::enumerable_thread_specific<std::vector<Task>>;
+
+// wraps a TBB range to record how many times it was split
+
+template <typename RangeT>
+struct TrackedRange
+{
+    TrackedRange(const RangeT& range_): range(range_) { }
+
+    TrackedRange(TrackedRange& other, tbb::split):
+        range(other.range, tbb::split()), depth(++other.depth) { }
+
+    bool empty() const { return range.empty(); }
+    bool is_divisible() const { return range.is_divisible(); }
+
+    RangeT range;
+    int depth = 0;
+};
+
+struct Balance
+{
+    double tasks = 0.0;
+    double maxDepth = 0.0;
+    double meanDepth = 0.0;
+    double taskImbalance = 0.0;     // max / mean work per task
+    double threadImbalance = 0.0;   // max / mean work per thread
+
+    void add(const TaskList& taskList, int threads)
+    {
+        size_t taskCount = 0;
+        size_t totalWork = 0;
+        size_t maxTaskWork = 0;
+        size_t maxThreadWork = 0;
+        int maxTaskDepth = 0;
+        size_t totalDepth = 0;
+
+        for (const auto& taskVector : taskList) {
+            size_t threadWork = 0;
+            for (const auto& task : taskVector) {
+                threadWork += task.work;
+                maxTaskWork = std::max(maxTaskWork, task.work);
+                maxTaskDepth = std::max(maxTaskDepth, task.depth);
+                totalDepth += task.depth;
+            }
+            taskCount += taskVector.size();
+            totalWork += threadWork;
+            maxThreadWork = std::max(maxThreadWork, threadWork);
+        }
+
+        if (taskCount == 0 || totalWork == 0)   return;
+
+        tasks += double(taskCount);
+        maxDepth += double(maxTaskDepth);
+        meanDepth += double(totalDepth) / double(taskCount);
+        taskImbalance += double(maxTaskWork) / (double(totalWork) / double(taskCount));
+        threadImbalance += double(maxThreadWork) / (double(totalWork) / double(threads));
+    }
+
+    Result result(double time, int iterations) const
+    {
+        return Result(time)
+            .metric("tasks", tasks / iterations)
+            .metric("max split depth", maxDepth / iterations)
+            .metric("mean split depth", meanDepth / iterations)
+            .metric("task imbalance", taskImbalance / iterations)
+            .metric("thread imbalance", threadImbalance / iterations);
+    }
+};
+
+// time a traversal of the range and record the work and split depth of every task,
+// the op processes the current item of the range and returns a value to accumulate
+
+template <typename RangeT, typename OpT>
+Result traverseRange(const std::function<RangeT()>& makeRange, const OpT& op,
+    bool threaded, int threads, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+    Balance balance;
+
+    for (int i = 0; i < iterations; i++) {
+
+        TaskList taskList;
+
+        auto body = [&](const TrackedRange<RangeT>& tracked) {
+            RangeT range(tracked.range);
+            size_t work = 0;
+            float sum = 0.0f;
+            for ( ; range; ++range) {
+                sum += op(range);
+                work++;
+            }
+            taskList.local().push_back({work, tracked.depth, sum});
+        };
+
+        evictCache();
+
+        timer.start();
+
+        TrackedRange<RangeT> range(makeRange());
+
+        if (threaded)   tbb::parallel_for(range, body);
+        else            body(range);
+
+        time += timer.milliseconds();
+
+        balance.add(taskList, threaded ? threads : 1);
+
+        for (const auto& taskVector : taskList) {
+            for (const auto& task : taskVector)     total += task.sum;
+        }
+    }
+
+    if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+
+    return balance.result(time/iterations, iterations);
+}
+
+Result leafIterRange(const FloatTree& tree, bool threaded, int threads, int iterations)
+{
+    using RangeT = tree::IteratorRange<FloatTree::LeafCIter>;
+    return traverseRange<RangeT>([&]() { return RangeT(tree.cbeginLeaf()); },
+        [](const RangeT& range) {
+            float sum = 0.0f;
+            for (auto iter = range.iterator()->cbeginValueOn(); iter; ++iter) {
+                sum += iter.getValue();
+            }
+            return sum;
+        }, threaded, threads, iterations);
+}
+
+Result nodeIterRange(const FloatTree& tree, bool threaded, int threads, int iterations)
+{
+    using RangeT = tree::IteratorRange<FloatTree::NodeCIter>;
+    return traverseRange<RangeT>([&]() { return RangeT(tree.cbeginNode()); },
+        [](const RangeT& range) { return float(range.iterator().getDepth()); },
+        threaded, threads, iterations);
+}
+
+Result valueIterRange(const FloatTree& tree, bool threaded, int threads, int iterations)
+{
+    using RangeT = tree::IteratorRange<FloatTree::ValueOnCIter>;
+    return traverseRange<RangeT>([&]() { return RangeT(tree.cbeginValueOn()); },
+        [](const RangeT& range) { return range.iterator().getValue(); },
+        threaded, threads, iterations);
+}
+
+// the LeafManager equivalent of leafIterRange using an array-based range of leaf nodes
+
+Result leafManagerRange(const FloatTree& tree, bool threaded, int threads, int iterations)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    float total = 0.0f;
+    Balance balance;
+
+    using RangeT = tree::LeafManager<const FloatTree>::LeafRange;
+
+    for (int i = 0; i < iterations; i++) {
+
+        TaskList taskList;
+
+        auto body = [&](const TrackedRange<RangeT>& tracked) {
+            size_t work = 0;
+            float sum = 0.0f;
+            for (auto leaf = tracked.range.begin(); leaf; ++leaf) {
+                for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                    sum += iter.getValue();
+                }
+                work++;
+            }
+            taskList.local().push_back({work, tracked.depth, sum});
+        };
+
+        evictCache();
+
+        timer.start();
+
+        tree::LeafManager<const FloatTree> leafManager(tree);
+        TrackedRange<RangeT> range(leafManager.leafRange(/*grainSize=*/1));
+
+        if (threaded)   tbb::parallel_for(range, body);
+        else            body(range);
+
+        time += timer.milliseconds();
+
+        balance.add(taskList, threaded ? threads : 1);
+
+        for (const auto& taskVector : taskList) {
+            for (const auto& task : taskVector)     total += task.sum;
+        }
+    }
+
+    if (total == 0.0f)     std::cerr << std::endl; // prevent optimization
+
+    return balance.result(time/iterations, iterations);
+}
+
+const bool registered = registerCases("iterator_range", {
+    { "Cloud Leaf Iterator Range", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return leafIterRange(ctx.tree(), ctx.threaded, ctx.threads, ctx.iterations); } },
+    { "Cloud Leaf LeafManager Range", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return leafManagerRange(ctx.tree(), ctx.threaded, ctx.threads, ctx.iterations); } },
+    { "Cloud Node Iterator Range", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return nodeIterRange(ctx.tree(), ctx.threaded, ctx.threads, ctx.iterations); } },
+    { "Cloud Value Iterator Range", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) { return valueIterRange(ctx.tree(), ctx.threaded, ctx.threads, ctx.iterations); } },
+});
+
+} // namespace
@@ -0,0 +1,204 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+using LeafT = FloatTree::LeafNodeType;
+using VecLeafT = Vec3fTree::LeafNodeType;
+
+// co-registered density, temperature and velocity grids derived from the asset, combined
+// per voxel into an output grid as result = density * temperature + |velocity|^2, every
+// tree shares the topology of the asset so the leaf nodes of all trees are in the same order
+
+struct Grids
+{
+    const FloatTree& density;
+    FloatTree temperature;
+    Vec3fTree velocity;
+    FloatTree result;
+
+    explicit Grids(const FloatTree& tree):
+        density(tree),
+        temperature(tree),
+        velocity(tree, Vec3f(0.0f), TopologyCopy()),
+        result(tree, 0.0f, TopologyCopy())
+    {
+        tree::LeafManager<FloatTree> temperatureLeafManager(temperature);
+        temperatureLeafManager.foreach([](LeafT& leaf, size_t) {
+            for (auto iter = leaf.beginValueOn(); iter; ++iter) {
+                iter.setValue(300.0f + iter.getValue() * 100.0f);
+            }
+        });
+
+        tree::LeafManager<Vec3fTree> velocityLeafManager(velocity);
+        velocityLeafManager.foreach([](VecLeafT& leaf, size_t) {
+            for (auto iter = leaf.beginValueOn(); iter; ++iter) {
+                const Coord& ijk = iter.getCoord();
+                iter.setValue(Vec3f(float(ijk.y() % 7), float(ijk.z() % 5), float(ijk.x() % 3)));
+            }
+        });
+    }
+
+    // the minimum memory traffic per active voxel: two floats and a Vec3f read (20 bytes), one
+    // float written (4 bytes)
+
+    static size_t bytesPerVoxel() { return sizeof(float) * 2 + sizeof(Vec3f) + sizeof(float); }
+};
+
+template <typename TraverseOp>
+Result timeTraversal(const FloatTree& refTree, int iterations, const TraverseOp& op)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+
+    Grids grids(refTree);
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        op(grids);
+
+        time += timer.milliseconds();
+    }
+
+    time /= iterations;
+
+    const double bytes = double(refTree.activeVoxelCount()) * double(Grids::bytesPerVoxel());
+    return Result(time).metric("bandwidth", bytes / (time * 1e6), "GB/s");
+}
+
+// one LeafManager pass per input grid, the leaves of each input grid are matched to the
+// leaves of the result by index
+
+void separatePasses(Grids& grids, bool threaded)
+{
+    tree::LeafManager<FloatTree> resultLeafManager(grids.result);
+
+    tree::LeafManager<const FloatTree> densityLeafManager(grids.density);
+    densityLeafManager.foreach([&](const LeafT& leaf, size_t n) {
+        LeafT& result = resultLeafManager.leaf(n);
+        for (auto iter = leaf.cbeginValueOn(); iter; ++iter) {
+            result.setValueOnly(iter.pos(), iter.getValue());
+        }
+    }, threaded, /*grainSize=*/1);
+
+    tree::LeafManager<const FloatTree> temperatureLeafManager(grids.temperature);
+    temperatureLeafManager.foreach([&](const LeafT& leaf, size_t n) {
+        LeafT& result = resultLeafManager.leaf(n);
+        for (auto iter = leaf.cbeginValueOn(); iter; ++iter) {
+            result.setValueOnly(iter.pos(), result.getValue(iter.pos()) * iter.getValue());
+        }
+    }, threaded, /*grainSize=*/1);
+
+    tree::LeafManager<const Vec3fTree> velocityLeafManager(grids.velocity);
+    velocityLeafManager.foreach([&](const VecLeafT& leaf, size_t n) {
+        LeafT& result = resultLeafManager.leaf(n);
+        for (auto iter = leaf.cbeginValueOn(); iter; ++iter) {
+            result.setValueOnly(iter.pos(), result.getValue(iter.pos()) + iter.getValue().lengthSqr());
+        }
+    }, threaded, /*grainSize=*/1);
+}
+
+// one LeafManager pass over the density, probing the other trees for the matching leaves,
+// which does not rely on the trees sharing the same topology
+
+struct ProbeOp
+{
+    ProbeOp(Grids& grids_): grids(grids_) { }
+
+    void operator()(const tree::LeafManager<const FloatTree>::LeafRange& range) const
+    {
+        tree::ValueAccessor<const FloatTree> temperatureAccessor(grids.temperature);
+        tree::ValueAccessor<const Vec3fTree> velocityAccessor(grids.velocity);
+        tree::ValueAccessor<FloatTree> resultAccessor(grids.result);
+
+        for (auto leaf = range.begin(); leaf; ++leaf) {
+            const LeafT* temperature = temperatureAccessor.probeConstLeaf(leaf->origin());
+            const VecLeafT* velocity = velocityAccessor.probeConstLeaf(leaf->origin());
+            LeafT* result = resultAccessor.probeLeaf(leaf->origin());
+            if (!temperature || !velocity || !result)   continue;
+            for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+                const Index n = iter.pos();
+                result->setValueOnly(n, iter.getValue() * temperature->getValue(n) + velocity->getValue(n).lengthSqr());
+            }
+        }
+    }
+
+    Grids& grids;
+};
+
+void probeLeaves(Grids& grids, bool threaded)
+{
+    tree::LeafManager<const FloatTree> leafManager(grids.density);
+    ProbeOp op(grids);
+    if (threaded)   tbb::parallel_for(leafManager.leafRange(), op);
+    else            op(leafManager.leafRange());
+}
+
+// Tree::combine2 and combine2Extended, with a temporary tree for the product of the density
+// and the temperature, like chaining the tools::comp* operations
+
+void combine(Grids& grids)
+{
+    auto multiply = [](const float& a, const float& b, float& result) { result = a * b; };
+    auto addSpeed = [](CombineArgs<float, Vec3f>& args) {
+        args.setResult(args.a() + args.b().lengthSqr());
+        args.setResultIsActive(args.aIsActive() || args.bIsActive());
+    };
+
+    FloatTree product(grids.density.background());
+    product.combine2(grids.density, grids.temperature, multiply);
+    grids.result.combine2Extended(product, grids.velocity, addSpeed);
+}
+
+// a single pass over the leaves of all trees at once, reading the value buffers directly
+
+void fusedKernel(Grids& grids, bool threaded)
+{
+    tree::LeafManager<const FloatTree> densityLeafManager(grids.density);
+    tree::LeafManager<const FloatTree> temperatureLeafManager(grids.temperature);
+    tree::LeafManager<const Vec3fTree> velocityLeafManager(grids.velocity);
+    tree::LeafManager<FloatTree> resultLeafManager(grids.result);
+
+    resultLeafManager.foreach([&](LeafT& leaf, size_t n) {
+        const float* density = densityLeafManager.leaf(n).buffer().data();
+        const float* temperature = temperatureLeafManager.leaf(n).buffer().data();
+        const Vec3f* velocity = velocityLeafManager.leaf(n).buffer().data();
+        float* result = leaf.buffer().data();
+        for (auto iter = densityLeafManager.leaf(n).getValueMask().beginOn(); iter; ++iter) {
+            const Index i = iter.pos();
+            result[i] = density[i] * temperature[i] + velocity[i].lengthSqr();
+        }
+    }, threaded, /*grainSize=*/1);
+}
+
+const bool registered = registerCases("multi_grid", {
+    { "Cloud Multi Grid Separate Passes", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) {
+            return timeTraversal(ctx.tree(), ctx.iterations, [&](Grids& grids) { separatePasses(grids, ctx.threaded); });
+        } },
+    { "Cloud Multi Grid Probe Leaves", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) {
+            return timeTraversal(ctx.tree(), ctx.iterations, [&](Grids& grids) { probeLeaves(grids, ctx.threaded); });
+        } },
+    { "Cloud Multi Grid Combine2", Case::Asset | Case::Serial,
+        [](const Context& ctx) {
+            return timeTraversal(ctx.tree(), ctx.iterations, [&](Grids& grids) { combine(grids); });
+        } },
+    { "Cloud Multi Grid Fused Kernel", Case::Asset | Case::Serial | Case::Threaded,
+        [](const Context& ctx) {
+            return timeTraversal(ctx.tree(), ctx.iterations, [&](Grids& grids) { fusedKernel(grids, ctx.threaded); });
+        } },
+});
+
+} // namespace
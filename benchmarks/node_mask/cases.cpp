@@ -0,0 +1,395 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/parallel_reduce.h>
+
+#include <functional>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BENCH_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+using LeafT = FloatTree::LeafNodeType;
+using UpperT = FloatTree::RootNodeType::ChildNodeType;
+using LowerT = UpperT::ChildNodeType;
+
+const Index WordCount = LeafT::NodeMaskType::WORD_COUNT;
+
+// sum op(begin, end) over [0, size), threaded when requested
+
+template <typename OpT>
+Index64 reduce(size_t size, size_t grainSize, bool threaded, const OpT& op)
+{
+    if (!threaded)  return op(size_t(0), size);
+
+    return tbb::parallel_reduce(tbb::blocked_range<size_t>(0, size, grainSize), Index64(0),
+        [&](const tbb::blocked_range<size_t>& range, Index64 sum) { return sum + op(range.begin(), range.end()); },
+        std::plus<Index64>());
+}
+
+template <typename CountOp>
+Result timeCount(int iterations, const CountOp& op)
+{
+    util::CpuTimer timer;
+    double time = 0.0f;
+    Index64 count = 0;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        count = op();
+
+        time += timer.milliseconds();
+    }
+
+    return Result(time/iterations).metric("count", double(count));
+}
+
+// the value masks of all leaves copied into one contiguous array of 64-bit words
+
+std::vector<Index64> flatLeafMasks(const tree::LeafManager<const FloatTree>& leafManager)
+{
+    std::vector<Index64> words(leafManager.leafCount() * WordCount);
+    for (size_t n = 0; n < leafManager.leafCount(); n++) {
+        const auto& mask = leafManager.leaf(n).getValueMask();
+        for (Index i = 0; i < WordCount; i++) {
+            words[n * WordCount + i] = mask.getWord<Index64>(i);
+        }
+    }
+    return words;
+}
+
+// the popcount kernels either count the bits of a, of a & b or of a | b
+
+enum class Combine { None, Intersection, Union };
+
+template <Combine C>
+inline Index64 combineWords(Index64 a, Index64 b)
+{
+    return C == Combine::Intersection ? (a & b) : (C == Combine::Union ? (a | b) : a);
+}
+
+// portable SWAR popcount, which is what compilers emit for __builtin_popcountll without POPCNT
+
+template <Combine C>
+Index64 popcountScalar(const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    Index64 count = 0;
+    for (size_t i = begin; i < end; i++) {
+        Index64 v = combineWords<C>(a[i], b[i]);
+        v = v - ((v >> 1) & 0x5555555555555555ull);
+        v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+        v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+        count += (v * 0x0101010101010101ull) >> 56;
+    }
+    return count;
+}
+
+// util::CountOn, as used by NodeMask::countOn
+
+template <Combine C>
+Index64 popcountCountOn(const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    Index64 count = 0;
+    for (size_t i = begin; i < end; i++) {
+        count += util::CountOn(combineWords<C>(a[i], b[i]));
+    }
+    return count;
+}
+
+#ifdef BENCH_X86_SIMD
+
+template <Combine C>
+__attribute__((target("popcnt")))
+Index64 popcountPOPCNT(const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    Index64 count = 0;
+    for (size_t i = begin; i < end; i++) {
+        count += Index64(_mm_popcnt_u64(combineWords<C>(a[i], b[i])));
+    }
+    return count;
+}
+
+// W. Mula, N. Kurz, D. Lemire, "Faster Population Counts Using AVX2 Instructions", 2018,
+// nibble lookups with vpshufb accumulated with vpsadbw
+
+template <Combine C>
+__attribute__((target("avx2")))
+Index64 popcountAVX2(const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+
+    __m256i total = _mm256_setzero_si256();
+    size_t i = begin;
+    for ( ; i + 4 <= end; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        if (C != Combine::None) {
+            const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+            v = C == Combine::Intersection ? _mm256_and_si256(v, w) : _mm256_or_si256(v, w);
+        }
+        const __m256i lo = _mm256_and_si256(v, low);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low);
+        const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, _mm256_setzero_si256()));
+    }
+
+    Index64 count = Index64(_mm256_extract_epi64(total, 0)) + Index64(_mm256_extract_epi64(total, 1)) +
+        Index64(_mm256_extract_epi64(total, 2)) + Index64(_mm256_extract_epi64(total, 3));
+    return count + popcountScalar<C>(a, b, i, end);
+}
+
+template <Combine C>
+__attribute__((target("avx512f,avx512vpopcntdq")))
+Index64 popcountAVX512(const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    __m512i total = _mm512_setzero_si512();
+    size_t i = begin;
+    for ( ; i + 8 <= end; i += 8) {
+        __m512i v = _mm512_loadu_si512(a + i);
+        if (C == Combine::Intersection)     v = _mm512_and_si512(v, _mm512_loadu_si512(b + i));
+        else if (C == Combine::Union)       v = _mm512_or_si512(v, _mm512_loadu_si512(b + i));
+        total = _mm512_add_epi64(total, _mm512_popcnt_epi64(v));
+    }
+    alignas(64) Index64 lanes[8];
+    _mm512_store_si512(lanes, total);
+    Index64 count = 0;
+    for (Index64 lane : lanes)  count += lane;
+    return count + popcountScalar<C>(a, b, i, end);
+}
+
+#endif
+
+enum class Kernel { Scalar, CountOn, POPCNT, AVX2, AVX512 };
+
+const char* kernelName(Kernel kernel)
+{
+    switch (kernel) {
+        case Kernel::Scalar:    return "Scalar";
+        case Kernel::CountOn:   return "CountOn";
+        case Kernel::POPCNT:    return "POPCNT";
+        case Kernel::AVX2:      return "AVX2";
+        case Kernel::AVX512:    return "AVX-512 VPOPCNTDQ";
+    }
+    return "";
+}
+
+// returns an empty string if the kernel is supported by this CPU
+
+std::string unsupported(Kernel kernel)
+{
+#ifdef BENCH_X86_SIMD
+    if (kernel == Kernel::POPCNT && !__builtin_cpu_supports("popcnt"))  return "POPCNT is not supported";
+    if (kernel == Kernel::AVX2 && !__builtin_cpu_supports("avx2"))      return "AVX2 is not supported";
+    if (kernel == Kernel::AVX512 && !(__builtin_cpu_supports("avx512f") &&
+            __builtin_cpu_supports("avx512vpopcntdq")))                 return "AVX-512 VPOPCNTDQ is not supported";
+#else
+    if (kernel == Kernel::POPCNT || kernel == Kernel::AVX2 || kernel == Kernel::AVX512) {
+        return "x86-64 SIMD kernels are not available";
+    }
+#endif
+    return "";
+}
+
+template <Combine C>
+Index64 popcount(Kernel kernel, const Index64* a, const Index64* b, size_t begin, size_t end)
+{
+    switch (kernel) {
+        case Kernel::Scalar:    return popcountScalar<C>(a, b, begin, end);
+        case Kernel::CountOn:   return popcountCountOn<C>(a, b, begin, end);
+#ifdef BENCH_X86_SIMD
+        case Kernel::POPCNT:    return popcountPOPCNT<C>(a, b, begin, end);
+        case Kernel::AVX2:      return popcountAVX2<C>(a, b, begin, end);
+        case Kernel::AVX512:    return popcountAVX512<C>(a, b, begin, end);
+#else
+        default:                break;
+#endif
+    }
+    return 0;
+}
+
+// count the bits of the flat leaf masks, for intersection and union each leaf mask is
+// combined with the mask of the next leaf
+
+template <Combine C>
+Result flatPopcount(const FloatTree& tree, Kernel kernel, bool threaded, int iterations)
+{
+    const std::string reason = unsupported(kernel);
+    if (!reason.empty())    return Result::skip(reason);
+
+    tree::LeafManager<const FloatTree> leafManager(tree);
+    const std::vector<Index64> words = flatLeafMasks(leafManager);
+
+    const size_t size = C == Combine::None ? words.size() : words.size() - std::min(words.size(), size_t(WordCount));
+    const Index64* a = words.data();
+    const Index64* b = words.data() + (C == Combine::None ? 0 : WordCount);
+
+    Result result = timeCount(iterations, [&]() {
+        return reduce(size, /*grainSize=*/4096, threaded,
+            [&](size_t begin, size_t end) { return popcount<C>(kernel, a, b, begin, end); });
+    });
+
+    return result.metric("bandwidth", double(size * sizeof(Index64) * (C == Combine::None ? 1 : 2)) /
+        (result.time * 1e6), "GB/s");
+}
+
+Result activeVoxelCount(const FloatTree& tree, int iterations)
+{
+    return timeCount(iterations, [&]() { return tree.activeVoxelCount(); });
+}
+
+Result activeLeafVoxelCount(const FloatTree& tree, int iterations)
+{
+    return timeCount(iterations, [&]() { return tree.activeLeafVoxelCount(); });
+}
+
+Result leafCountOn(const FloatTree& tree, bool threaded, int iterations)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+
+    return timeCount(iterations, [&]() {
+        return reduce(leafManager.leafCount(), /*grainSize=*/64, threaded, [&](size_t begin, size_t end) {
+            Index64 count = 0;
+            for (size_t n = begin; n < end; n++) {
+                count += leafManager.leaf(n).getValueMask().countOn();
+            }
+            return count;
+        });
+    });
+}
+
+// the child and value masks of the internal nodes
+
+Result internalCountOn(const FloatTree& tree, bool threaded, int iterations)
+{
+    std::vector<const LowerT*> lowerNodes;
+    std::vector<const UpperT*> upperNodes;
+    tree.getNodes(lowerNodes);
+    tree.getNodes(upperNodes);
+
+    auto countOn = [&](const auto& nodes) {
+        return reduce(nodes.size(), /*grainSize=*/1, threaded, [&](size_t begin, size_t end) {
+            Index64 count = 0;
+            for (size_t n = begin; n < end; n++) {
+                count += nodes[n]->getChildMask().countOn() + nodes[n]->getValueMask().countOn();
+            }
+            return count;
+        });
+    };
+
+    return timeCount(iterations, [&]() { return countOn(lowerNodes) + countOn(upperNodes); });
+}
+
+// visit the active voxels of every leaf with the on-iterator of the mask, which is what drives
+// beginValueOn(), or with explicit findFirstOn and findNextOn calls
+
+Result leafOnIterator(const FloatTree& tree, bool threaded, int iterations)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+
+    return timeCount(iterations, [&]() {
+        return reduce(leafManager.leafCount(), /*grainSize=*/64, threaded, [&](size_t begin, size_t end) {
+            Index64 sum = 0;
+            for (size_t n = begin; n < end; n++) {
+                for (auto iter = leafManager.leaf(n).getValueMask().beginOn(); iter; ++iter) {
+                    sum += iter.pos();
+                }
+            }
+            return sum;
+        });
+    });
+}
+
+Result leafFindNextOn(const FloatTree& tree, bool threaded, int iterations)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+
+    return timeCount(iterations, [&]() {
+        return reduce(leafManager.leafCount(), /*grainSize=*/64, threaded, [&](size_t begin, size_t end) {
+            Index64 sum = 0;
+            for (size_t n = begin; n < end; n++) {
+                const auto& mask = leafManager.leaf(n).getValueMask();
+                for (Index i = mask.findFirstOn(); i < LeafT::SIZE; i = mask.findNextOn(i + 1)) {
+                    sum += i;
+                }
+            }
+            return sum;
+        });
+    });
+}
+
+// intersect or union each leaf mask with the mask of the next leaf using the NodeMask operators
+
+template <Combine C>
+Result leafCombine(const FloatTree& tree, bool threaded, int iterations)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+    const size_t size = leafManager.leafCount() > 0 ? leafManager.leafCount() - 1 : 0;
+
+    return timeCount(iterations, [&]() {
+        return reduce(size, /*grainSize=*/64, threaded, [&](size_t begin, size_t end) {
+            Index64 count = 0;
+            for (size_t n = begin; n < end; n++) {
+                LeafT::NodeMaskType mask = leafManager.leaf(n).getValueMask();
+                if (C == Combine::Intersection)     mask &= leafManager.leaf(n + 1).getValueMask();
+                else                                mask |= leafManager.leaf(n + 1).getValueMask();
+                count += mask.countOn();
+            }
+            return count;
+        });
+    });
+}
+
+std::vector<Case> nodeMaskCases()
+{
+    const int flags = Case::Asset | Case::Serial | Case::Threaded;
+
+    std::vector<Case> cases = {
+        { "Cloud Tree Active Voxel Count", Case::Asset | Case::Threaded,
+            [](const Context& ctx) { return activeVoxelCount(ctx.tree(), ctx.iterations); } },
+        { "Cloud Tree Active Leaf Voxel Count", Case::Asset | Case::Threaded,
+            [](const Context& ctx) { return activeLeafVoxelCount(ctx.tree(), ctx.iterations); } },
+        { "Cloud Leaf Mask countOn", flags,
+            [](const Context& ctx) { return leafCountOn(ctx.tree(), ctx.threaded, ctx.iterations); } },
+        { "Cloud Internal Mask countOn", flags,
+            [](const Context& ctx) { return internalCountOn(ctx.tree(), ctx.threaded, ctx.iterations); } },
+        { "Cloud Leaf Mask On Iterator", flags,
+            [](const Context& ctx) { return leafOnIterator(ctx.tree(), ctx.threaded, ctx.iterations); } },
+        { "Cloud Leaf Mask findFirstOn findNextOn", flags,
+            [](const Context& ctx) { return leafFindNextOn(ctx.tree(), ctx.threaded, ctx.iterations); } },
+        { "Cloud Leaf Mask Intersection", flags,
+            [](const Context& ctx) { return leafCombine<Combine::Intersection>(ctx.tree(), ctx.threaded, ctx.iterations); } },
+        { "Cloud Leaf Mask Union", flags,
+            [](const Context& ctx) { return leafCombine<Combine::Union>(ctx.tree(), ctx.threaded, ctx.iterations); } },
+    };
+
+    for (Kernel kernel : { Kernel::Scalar, Kernel::CountOn, Kernel::POPCNT, Kernel::AVX2, Kernel::AVX512 }) {
+        const std::string suffix = std::string(" ") + kernelName(kernel);
+        cases.push_back({ "Cloud Flat Popcount" + suffix, flags,
+            [=](const Context& ctx) { return flatPopcount<Combine::None>(ctx.tree(), kernel, ctx.threaded, ctx.iterations); } });
+        cases.push_back({ "Cloud Flat Intersection Popcount" + suffix, flags,
+            [=](const Context& ctx) { return flatPopcount<Combine::Intersection>(ctx.tree(), kernel, ctx.threaded, ctx.iterations); } });
+        cases.push_back({ "Cloud Flat Union Popcount" + suffix, flags,
+            [=](const Context& ctx) { return flatPopcount<Combine::Union>(ctx.tree(), kernel, ctx.threaded, ctx.iterations); } });
+    }
+
+    return cases;
+}
+
+const bool registered = registerCases("node_mask", nodeMaskCases());
+
+} // namespace
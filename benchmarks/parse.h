@@ -1,102 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
+
+struct Option
+{
+    const char* name;
+    const char* arg;    // name of the argument or nullptr if the option is a flag
+    const char* help;
+};
+
+inline const std::vector<Option>& options()
+{
+    static const std::vector<Option> result = {
+        { "-iterations", "N", "number of benchmark iterations to perform (defaults to 10)" },
+        { "-repetitions", "N", "number of times to repeat each benchmark, reporting mean, min and max (defaults to 1)" },
+        { "-vdb", "S", "filepath to a VDB, a directory of VDBs or a comma-separated list of either (defaults to \"wdas_cloud.vdb\")" },
+        { "-grid", "S", "name of the float grid to load from each VDB or \"*\" for every float grid (defaults to the first float grid)" },
+        { "-snapshots", "S", "directory of preprocessed VDB snapshots to load the VDB from, written on first use" },
+        { "-cpus", "N", "max number of CPUs to perform multi-threaded benchmarks (defaults to the number of logical cores)" },
+        { "-filter", "R", "only run the benchmarks whose \"suite/name\" matches the regular expression R" },
+        { "-format", "S", "output format, one of \"text\", \"csv\" or \"json\" (defaults to \"text\")" },
+        { "-cache", "S", "cache state at the start of each iteration, one of \"warm\", \"cold\" or \"both\" (defaults to \"warm\"), a cold cache is only evicted from the calling thread's core and the shared last-level cache" },
+        { "-remap", nullptr, "with a cold cache, also copy read-only trees to new memory before each iteration (the copy is written before the caches are evicted)" },
+        { "-misses", "F", "fraction of the direct_access queries that land in the background or inactive tiles (defaults to 0)" },
+        { "-trace", "S", "write a Chrome trace-event JSON file of the LeafManager and NodeManager task chunks to S" },
+        { "-allocator", "S", "allocator for the tree nodes of the loaded VDB, one of \"system\" or \"pool\" (defaults to \"system\")" },
+        { "-hugepages", nullptr, "back the pool allocator with transparent 2MB huge pages" },
+        { "-list", nullptr, "print the names of the selected benchmarks and exit" },
+    };
+    return result;
+}
 
 struct OptParse
 {
-    int argc;
-    char** argv;
     const char* binary;
-    bool vdbArg;
-    bool cpusArg;
+    std::map<std::string, std::string> values;
+
+    // argv is scanned a single time on construction, accessors only perform a lookup
 
-    OptParse(int argc_, char* argv_[], bool _vdbArg, bool _cpusArg):
-        argc(argc_), argv(argv_), binary(argv[0]), vdbArg(_vdbArg), cpusArg(_cpusArg)
+    OptParse(int argc, char* argv[]):
+        binary(argv[0])
     {
-        help();
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "-h" || arg == "-help" || arg == "--help") {
+                usage();
+            }
+            auto iter = std::find_if(options().begin(), options().end(),
+                [&](const Option& option) { return arg == option.name; });
+            if (iter == options().end()) {
+                std::cerr << "unrecognized option " << arg << "\n";
+                usage(1);
+            }
+            if (iter->arg) {
+                if (i + 1 >= argc) {
+                    std::cerr << "option " << arg << " requires 1 argument\n";
+                    usage(1);
+                }
+                values[arg] = argv[++i];
+            } else {
+                values[arg] = "";
+            }
+        }
     }
 
     void
-    usage [[noreturn]] () const
+    usage [[noreturn]] (int status = 0) const
     {
         std::ostringstream ostr;
         ostr << "Usage: " << binary << " [options]\n" <<
-        "Options:\n" <<
-        "   -iterations N   number of benchmark iterations to perform (defaults to 10)\n";
-        if (vdbArg) {
-            ostr << "   -vdb S          filepath to a VDB (defaults to \"wdas_cloud.vdb\"\n";
+        "Options:\n";
+        for (const auto& option : options()) {
+            std::string name = std::string(option.name) + (option.arg ? std::string(" ") + option.arg : "");
+            name.resize(std::max(name.size(), size_t(15)), ' ');
+            ostr << "   " << name << " " << option.help << "\n";
         }
-        if (cpusArg) {
-            ostr << "   -cpus N         max number of CPUs to perform multi-threaded benchmarks (defaults to " <<
-                std::thread::hardware_concurrency() << ")\n";
-        }
-        "   -h, -help       print this usage message and exit\n";
+        ostr << "   -h, -help       print this usage message and exit\n";
         std::cerr << ostr.str();
-        exit(0);
+        exit(status);
     }
 
-    bool check(int idx, const std::string& name, int numArgs = 1) const
+    bool has(const std::string& name) const
     {
-        if (argv[idx] == name) {
-            if (idx + numArgs >= argc) {
-                std::cerr << "option " << name << " requires "
-                    << numArgs << " argument" << (numArgs == 1 ? "" : "s");
-                usage();
-            }
-            return true;
-        }
-        return false;
+        return values.find(name) != values.end();
     }
 
-    void help() const
+    std::string get(const std::string& name, const std::string& defaultValue) const
     {
-        for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
-            if (arg == "-h" || arg == "-help" || arg == "--help") {
-                usage();
-            }
-        }
+        auto iter = values.find(name);
+        return iter == values.end() ? defaultValue : iter->second;
+    }
+
+    int getInt(const std::string& name, int defaultValue, int minValue = 1) const
+    {
+        auto iter = values.find(name);
+        return iter == values.end() ? defaultValue : std::max(minValue, atoi(iter->second.c_str()));
+    }
+
+    double getDouble(const std::string& name, double defaultValue) const
+    {
+        auto iter = values.find(name);
+        return iter == values.end() ? defaultValue : atof(iter->second.c_str());
     }
 
     std::string vdb() const
     {
-        std::string result = "wdas_cloud.vdb";
-        for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
-            if (arg[0] == '-') {
-                if (check(i, "-vdb")) {
-                    ++i;
-                    result = argv[i];
-                }
-            }
+        return get("-vdb", "wdas_cloud.vdb");
+    }
+
+    std::string grid() const
+    {
+        return get("-grid", "");
+    }
+
+    int iterations() const
+    {
+        return getInt("-iterations", 10);
+    }
+
+    int repetitions() const
+    {
+        return getInt("-repetitions", 1);
+    }
+
+    int cpus() const
+    {
+        return getInt("-cpus", std::thread::hardware_concurrency());
+    }
+
+    double misses() const
+    {
+        return std::min(1.0, std::max(0.0, getDouble("-misses", 0.0)));
+    }
+
+    std::string filter() const
+    {
+        return get("-filter", "");
+    }
+
+    std::string cache() const
+    {
+        std::string result = get("-cache", "warm");
+        if (result != "warm" && result != "cold" && result != "both") {
+            std::cerr << "unsupported cache mode " << result << "\n";
+            usage(1);
         }
         return result;
     }
 
-    int iterations() const
+    std::string allocator() const
     {
-        int result = 10;
-        for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
-            if (arg[0] == '-') {
-                if (check(i, "-iterations")) {
-                    ++i;
-                    result = std::max(1, atoi(argv[i]));
-                }
-            }
+        std::string result = get("-allocator", "system");
+        if (result != "system" && result != "pool") {
+            std::cerr << "unsupported allocator " << result << "\n";
+            usage(1);
         }
         return result;
     }
 
-    int cpus() const
+    std::string format() const
     {
-        int result = std::thread::hardware_concurrency();
-        for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
-            if (arg[0] == '-') {
-                if (check(i, "-cpus")) {
-                    ++i;
-                    result = std::max(1, atoi(argv[i]));
-                }
-            }
+        std::string result = get("-format", "text");
+        if (result != "text" && result != "csv" && result != "json") {
+            std::cerr << "unsupported format " << result << "\n";
+            usage(1);
         }
         return result;
     }
@@ -0,0 +1,307 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <tbb/parallel_sort.h>
+
+#include <random>
+#include <vector>
+
+#include "extract.h"
+
+using namespace openvdb;
+
+// coordinate access patterns used by the random-access benchmarks, all patterns generate
+// roughly one query per active voxel and replace a fraction of the queries with coordinates
+// that land in the background or in inactive tiles
+
+enum class Pattern
+{
+    Sequential,     // active voxels in leaf order
+    Interleaved,    // active voxels alternating between the children of the root
+    Random,         // uniform random coordinates within the active voxel bounding box
+    Morton,         // active voxels sorted along a Morton (Z-order) curve
+    Hilbert,        // active voxels sorted along a Hilbert curve
+    RayWalk,        // voxels visited by straight rays marched through the bounding box
+    StencilWalk     // 7-point stencils centered on active voxels in leaf order
+};
+
+inline const char* patternName(Pattern pattern)
+{
+    switch (pattern) {
+        case Pattern::Sequential:   return "Sequential";
+        case Pattern::Interleaved:  return "Interleaved";
+        case Pattern::Random:       return "Random";
+        case Pattern::Morton:       return "Morton";
+        case Pattern::Hilbert:      return "Hilbert";
+        case Pattern::RayWalk:      return "Ray Walk";
+        case Pattern::StencilWalk:  return "Stencil Walk";
+    }
+    return "";
+}
+
+// the serial reference for addActiveVoxelIJKs
+
+inline void addSequentialVoxelIJKs(const FloatTree& tree, std::vector<Coord>& ijks)
+{
+    ijks.clear();
+
+    for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+        for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+            ijks.emplace_back(iter.getCoord());
+        }
+    }
+}
+
+inline void addInterleavedVoxelIJKs(const FloatTree& tree, std::vector<Coord>& ijks)
+{
+    // in leaf order the active voxels of each child of the root are contiguous
+
+    std::vector<Coord> sequential;
+    addActiveVoxelIJKs(tree, sequential);
+
+    const Int32 mask = ~Int32(FloatTree::RootNodeType::ChildNodeType::DIM - 1);
+
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t n = 0; n < sequential.size(); n++) {
+        if (n == 0 || (sequential[n] & mask) != (sequential[n-1] & mask)) {
+            ranges.emplace_back(n, n);
+        }
+        ranges.back().second = n + 1;
+    }
+
+    ijks.clear();
+    ijks.reserve(sequential.size());
+
+    for (size_t i = 0; ijks.size() < sequential.size(); i++) {
+        for (const auto& range : ranges) {
+            if (range.first + i < range.second) {
+                ijks.push_back(sequential[range.first + i]);
+            }
+        }
+    }
+}
+
+inline void addRandomIJKs(const CoordBBox& bbox, size_t count, std::mt19937& rng, std::vector<Coord>& ijks)
+{
+    ijks.clear();
+    ijks.reserve(count);
+
+    std::uniform_int_distribution<Int32> x(bbox.min().x(), bbox.max().x());
+    std::uniform_int_distribution<Int32> y(bbox.min().y(), bbox.max().y());
+    std::uniform_int_distribution<Int32> z(bbox.min().z(), bbox.max().z());
+
+    for (size_t n = 0; n < count; n++) {
+        ijks.emplace_back(x(rng), y(rng), z(rng));
+    }
+}
+
+// keys of a space-filling curve for coordinates relative to the bounding box, using 21 bits per axis
+
+inline uint64_t mortonKey(uint32_t x, uint32_t y, uint32_t z)
+{
+    uint64_t key = 0;
+    for (int b = 20; b >= 0; b--) {
+        key = (key << 3) | (((x >> b) & 1) << 2) | (((y >> b) & 1) << 1) | ((z >> b) & 1);
+    }
+    return key;
+}
+
+// J. Skilling, "Programming the Hilbert curve", AIP Conference Proceedings 707, 2004
+
+inline uint64_t hilbertKey(uint32_t x, uint32_t y, uint32_t z)
+{
+    uint32_t X[3] = { x, y, z };
+    const uint32_t M = 1u << 20;
+
+    // inverse undo
+
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        const uint32_t P = Q - 1;
+        for (int i = 0; i < 3; i++) {
+            if (X[i] & Q) {
+                X[0] ^= P;
+            } else {
+                const uint32_t t = (X[0] ^ X[i]) & P;
+                X[0] ^= t;
+                X[i] ^= t;
+            }
+        }
+    }
+
+    // gray encode
+
+    X[1] ^= X[0];
+    X[2] ^= X[1];
+    uint32_t t = 0;
+    for (uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (X[2] & Q)   t ^= Q - 1;
+    }
+    for (int i = 0; i < 3; i++)     X[i] ^= t;
+
+    return mortonKey(X[0], X[1], X[2]);
+}
+
+template <typename KeyOp>
+inline void sortIJKs(const CoordBBox& bbox, const KeyOp& keyOp, std::vector<Coord>& ijks)
+{
+    const uint32_t mask = (1u << 21) - 1;
+
+    std::vector<std::pair<uint64_t, Coord>> keys(ijks.size());
+    for (size_t n = 0; n < ijks.size(); n++) {
+        const Coord offset = ijks[n] - bbox.min();
+        keys[n].first = keyOp(uint32_t(offset.x()) & mask, uint32_t(offset.y()) & mask, uint32_t(offset.z()) & mask);
+        keys[n].second = ijks[n];
+    }
+
+    tbb::parallel_sort(keys.begin(), keys.end(),
+        [](const std::pair<uint64_t, Coord>& a, const std::pair<uint64_t, Coord>& b) { return a.first < b.first; });
+
+    for (size_t n = 0; n < ijks.size(); n++) {
+        ijks[n] = keys[n].second;
+    }
+}
+
+// march rays voxel by voxel from a random point on the surface of the bounding box in a
+// random direction until they leave the bounding box
+
+inline void addRayWalkIJKs(const CoordBBox& bbox, size_t count, std::mt19937& rng, std::vector<Coord>& ijks)
+{
+    ijks.clear();
+    ijks.reserve(count);
+
+    const Vec3d min = bbox.min().asVec3d();
+    const Vec3d max = bbox.max().asVec3d();
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::normal_distribution<double> normal;
+
+    while (ijks.size() < count) {
+        Vec3d position(min + (max - min) * Vec3d(unit(rng), unit(rng), unit(rng)));
+        const int axis = int(unit(rng) * 3) % 3;
+        const bool upper = unit(rng) < 0.5;
+        position[axis] = upper ? max[axis] : min[axis];
+
+        Vec3d direction(normal(rng), normal(rng), normal(rng));
+        if (direction.normalize() == false)     continue;
+        if ((direction[axis] > 0.0) == upper)   direction[axis] = -direction[axis];
+
+        const size_t size = ijks.size();
+        for ( ; ijks.size() < count; position += direction) {
+            const Coord ijk = Coord::round(position);
+            if (!bbox.isInside(ijk))    break;
+            if (ijks.size() == size || ijks.back() != ijk)  ijks.push_back(ijk);
+        }
+    }
+}
+
+inline void addStencilWalkIJKs(const FloatTree& tree, std::vector<Coord>& ijks)
+{
+    ijks.clear();
+
+    // center a stencil on every seventh active voxel so that the number of queries matches
+    // the number of active voxels
+
+    size_t n = 0;
+    for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+        for (auto iter = leaf->cbeginValueOn(); iter; ++iter) {
+            if (n++ % 7 != 0)   continue;
+            const Coord ijk = iter.getCoord();
+            ijks.push_back(ijk);
+            ijks.push_back(ijk.offsetBy(-1, 0, 0));
+            ijks.push_back(ijk.offsetBy(1, 0, 0));
+            ijks.push_back(ijk.offsetBy(0, -1, 0));
+            ijks.push_back(ijk.offsetBy(0, 1, 0));
+            ijks.push_back(ijk.offsetBy(0, 0, -1));
+            ijks.push_back(ijk.offsetBy(0, 0, 1));
+        }
+    }
+}
+
+// replace a fraction of the queries with coordinates in inactive tiles of the tree
+// (if there are any) and in the background beyond the active voxel bounding box
+
+inline void addMisses(const FloatTree& tree, const CoordBBox& bbox, double fraction,
+    std::mt19937& rng, std::vector<Coord>& ijks)
+{
+    if (fraction <= 0.0 || ijks.empty())    return;
+
+    std::vector<CoordBBox> tiles;
+    auto iter = tree.cbeginValueOff();
+    iter.setMaxDepth(FloatTree::ValueOffCIter::LEAF_DEPTH - 1);
+    for ( ; iter; ++iter) {
+        if (!iter.isTileValue())    continue;
+        CoordBBox tileBBox;
+        iter.getBoundingBox(tileBBox);
+        tiles.push_back(tileBBox);
+    }
+
+    const Int32 dim = FloatTree::RootNodeType::ChildNodeType::DIM;
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<Int32> offset(0, dim - 1);
+    std::uniform_int_distribution<size_t> tileIndex(0, tiles.empty() ? 0 : tiles.size() - 1);
+
+    for (auto& ijk : ijks) {
+        if (unit(rng) >= fraction)  continue;
+        if (!tiles.empty() && unit(rng) < 0.5) {
+            const CoordBBox& tile = tiles[tileIndex(rng)];
+            const Coord dims = tile.dim();
+            ijk = tile.min().offsetBy(offset(rng) % dims.x(), offset(rng) % dims.y(), offset(rng) % dims.z());
+        } else {
+            // two root node children beyond the bounding box is outside of any child of the root
+
+            ijk = Coord(bbox.max().x() + 2 * dim + offset(rng), bbox.min().y() + offset(rng), bbox.min().z() + offset(rng));
+        }
+    }
+}
+
+inline void addPatternIJKs(const FloatTree& tree, Pattern pattern, double missFraction, std::vector<Coord>& ijks)
+{
+    std::mt19937 rng(0);
+
+    CoordBBox bbox;
+    tree.evalActiveVoxelBoundingBox(bbox);
+    const size_t count = size_t(tree.activeVoxelCount());
+
+    // an empty tree has an inverted bounding box, so there is nothing to query
+
+    ijks.clear();
+    if (bbox.empty())   return;
+
+    switch (pattern) {
+        case Pattern::Sequential:   addActiveVoxelIJKs(tree, ijks); break;
+        case Pattern::Interleaved:  addInterleavedVoxelIJKs(tree, ijks); break;
+        case Pattern::Random:       addRandomIJKs(bbox, count, rng, ijks); break;
+        case Pattern::Morton:       addActiveVoxelIJKs(tree, ijks); sortIJKs(bbox, mortonKey, ijks); break;
+        case Pattern::Hilbert:      addActiveVoxelIJKs(tree, ijks); sortIJKs(bbox, hilbertKey, ijks); break;
+        case Pattern::RayWalk:      addRayWalkIJKs(bbox, count, rng, ijks); break;
+        case Pattern::StencilWalk:  addStencilWalkIJKs(tree, ijks); break;
+    }
+
+    addMisses(tree, bbox, missFraction, rng, ijks);
+}
+
+// the fraction of queries that land in the same node as the previous query at each level of the
+// tree, which is an upper bound on the hit rate of the corresponding level of a ValueAccessor cache
+
+inline std::vector<double> patternLocality(const std::vector<Coord>& ijks)
+{
+    using LeafT = FloatTree::LeafNodeType;
+    using UpperT = FloatTree::RootNodeType::ChildNodeType;
+    using LowerT = UpperT::ChildNodeType;
+
+    const Int32 masks[3] = { ~Int32(LeafT::DIM - 1), ~Int32(LowerT::DIM - 1), ~Int32(UpperT::DIM - 1) };
+    size_t hits[3] = { 0, 0, 0 };
+
+    for (size_t n = 1; n < ijks.size(); n++) {
+        for (int level = 0; level < 3; level++) {
+            const Coord a = ijks[n] & masks[level];
+            const Coord b = ijks[n-1] & masks[level];
+            if (a == b)     hits[level]++;
+        }
+    }
+
+    const double size = double(std::max(ijks.size(), size_t(1)));
+    return { hits[0] / size, hits[1] / size, hits[2] / size };
+}
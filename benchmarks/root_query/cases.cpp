@@ -0,0 +1,177 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+void addOneTile(FloatTree& tree)
+{
+    tree.addTile(0, Coord(0, 0, 0), 1.0f, true);
+}
+
+void addEightTiles(FloatTree& tree)
+{
+    for (int i = -4096; i <= 0; i += 4096) {
+        for (int j = -4096; j <= 0; j += 4096) {
+            for (int k = -4096; k <= 0; k += 4096) {
+                tree.addTile(0, Coord(i, j, k), 1.0f, true);
+            }
+        }
+    }
+}
+
+void addSixtyFourTiles(FloatTree& tree)
+{
+    for (int i = -(4096*2); i <= 4096; i += 4096) {
+        for (int j = -(4096*2); j <= 4096; j += 4096) {
+            for (int k = -(4096*2); k <= 4096; k += 4096) {
+                tree.addTile(0, Coord(i, j, k), 1.0f, true);
+            }
+        }
+    }
+}
+
+void addCoalescedIJKs(FloatTree& tree, std::vector<Coord>& ijks, size_t count)
+{
+    ijks.clear();
+    ijks.reserve(8*count);
+
+    for (int tileIndex = 0; tileIndex < 8; tileIndex++) {
+        Int32 i(0);
+        Int32 j(0);
+        Int32 k(0);
+        if ((tileIndex & 1) != 0)   i -= 4096;
+        if ((tileIndex & 2) != 0)   j -= 4096;
+        if ((tileIndex & 4) != 0)   k -= 4096;
+        for (int n = 0; n < count; n++) {
+            ijks.emplace_back(i, j, k);
+        }
+    }
+}
+
+void addInterleavedIJKs(FloatTree& tree, std::vector<Coord>& ijks, size_t count)
+{
+    ijks.clear();
+    ijks.reserve(8*count);
+
+    for (int n = 0; n < count; n++) {
+        for (int tileIndex = 0; tileIndex < 8; tileIndex++) {
+            Int32 i(0);
+            Int32 j(0);
+            Int32 k(0);
+            if ((tileIndex & 1) != 0)   i -= 4096;
+            if ((tileIndex & 2) != 0)   j -= 4096;
+            if ((tileIndex & 4) != 0)   k -= 4096;
+            ijks.emplace_back(i, j, k);
+        }
+    }
+}
+
+void warmup(FloatTree& tree, const std::vector<Coord>& ijks)
+{
+    int total = 0;
+    auto& root = tree.root();
+    for (const auto& ijk : ijks) {
+        total += root.getValueDepth(ijk);
+    }
+    if (total == 0)     std::cerr << std::endl; // prevent optimization
+}
+
+double rootQueryDirect(FloatTree& tree, const std::vector<Coord>& ijks, int iterations)
+{
+    util::CpuTimer timer;
+    auto& root = tree.root();
+    int total = 0;
+    double time = 0.0f;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        for (const auto& ijk : ijks) {
+            total += root.getValueDepth(ijk);
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+double rootQueryAccessor(FloatTree& tree, const std::vector<Coord>& ijks, int iterations)
+{
+    util::CpuTimer timer;
+    auto& root = tree.root();
+    int total = 0;
+    double time = 0.0f;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        tree::ValueAccessor<FloatTree> valueAccessor(tree);
+
+        for (const auto& ijk : ijks) {
+            total += valueAccessor.getValueDepth(ijk);
+        }
+
+        time += timer.milliseconds();
+
+        if (total == 0)     std::cerr << std::endl; // prevent optimization
+    }
+
+    return time/iterations;
+}
+
+double rootQuery(void (*addTiles)(FloatTree&),
+    void (*addIJKs)(FloatTree&, std::vector<Coord>&, size_t), bool accessor, int iterations)
+{
+    std::vector<Coord> ijks;
+    size_t count = 100 * 1000 * 1000;
+
+    FloatTree tree;
+    addTiles(tree);
+    addIJKs(tree, ijks, count);
+    warmup(tree, ijks);
+
+    return accessor ? rootQueryAccessor(tree, ijks, iterations) : rootQueryDirect(tree, ijks, iterations);
+}
+
+const bool registered = registerCases("root_query", {
+    { "1 Tile Coalesced Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addOneTile, addCoalescedIJKs, false, ctx.iterations); } },
+    { "1 Tile Coalesced Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addOneTile, addCoalescedIJKs, true, ctx.iterations); } },
+    { "1 Tile Interleaved Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addOneTile, addInterleavedIJKs, false, ctx.iterations); } },
+    { "1 Tile Interleaved Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addOneTile, addInterleavedIJKs, true, ctx.iterations); } },
+    { "8 Tiles Coalesced Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addEightTiles, addCoalescedIJKs, false, ctx.iterations); } },
+    { "8 Tiles Coalesced Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addEightTiles, addCoalescedIJKs, true, ctx.iterations); } },
+    { "8 Tiles Interleaved Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addEightTiles, addInterleavedIJKs, false, ctx.iterations); } },
+    { "8 Tiles Interleaved Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addEightTiles, addInterleavedIJKs, true, ctx.iterations); } },
+    { "64 Tiles Coalesced Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addSixtyFourTiles, addCoalescedIJKs, false, ctx.iterations); } },
+    { "64 Tiles Coalesced Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addSixtyFourTiles, addCoalescedIJKs, true, ctx.iterations); } },
+    { "64 Tiles Interleaved Root Query Direct", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addSixtyFourTiles, addInterleavedIJKs, false, ctx.iterations); } },
+    { "64 Tiles Interleaved Root Query Accessor", Case::Serial,
+        [](const Context& ctx) { return rootQuery(addSixtyFourTiles, addInterleavedIJKs, true, ctx.iterations); } },
+});
+
+} // namespace
@@ -0,0 +1,125 @@
+
+#include <openvdb/openvdb.h>
+#include <openvdb/io/Compression.h>
+#include <openvdb/io/io.h>
+#include <openvdb/util/CpuTimer.h>
+
+#include <sstream>
+
+#include "../bench.h"
+
+using namespace openvdb;
+
+namespace {
+
+struct Codec
+{
+    const char* name;
+    uint32_t compression;
+    bool half;
+};
+
+std::string encode(const FloatGrid& grid, const Codec& codec)
+{
+    std::ostringstream ostr(std::ios_base::binary);
+
+    // configure the stream in the same way as io::Archive does before writing a grid
+
+    io::setDataCompression(ostr, codec.compression);
+    io::setGridBackgroundValuePtr(ostr, &grid.background());
+
+    grid.writeTopology(ostr);
+    grid.writeBuffers(ostr);
+
+    return ostr.str();
+}
+
+FloatGrid::Ptr decode(const std::string& bytes, const Codec& codec, const float& background)
+{
+    std::istringstream istr(bytes, std::ios_base::binary);
+
+    io::setCurrentVersion(istr);
+    io::setDataCompression(istr, codec.compression);
+    io::setGridBackgroundValuePtr(istr, &background);
+
+    FloatGrid::Ptr grid = FloatGrid::create();
+    grid->setSaveFloatAsHalf(codec.half);
+
+    grid->readTopology(istr);
+    grid->readBuffers(istr);
+
+    return grid;
+}
+
+Result serialize(const FloatTree& refTree, const Codec& codec, int iterations)
+{
+    if ((codec.compression & io::COMPRESS_BLOSC) && !io::Archive::hasBloscCompression()) {
+        return Result::skip("Blosc is not supported by this build of OpenVDB");
+    }
+
+    util::CpuTimer timer;
+    double encodeTime = 0.0f;
+    double decodeTime = 0.0f;
+    Index64 total = 0;
+
+    FloatGrid::Ptr grid = FloatGrid::create(std::make_shared<FloatTree>(refTree));
+
+    // the uncompressed payload size is the reference for all throughput and ratio numbers
+
+    const size_t rawBytes = encode(*grid, { "None", io::COMPRESS_NONE, false }).size();
+
+    grid->setSaveFloatAsHalf(codec.half);
+
+    std::string bytes;
+
+    for (int i = 0; i < iterations; i++) {
+
+        evictCache();
+
+        timer.start();
+
+        bytes = encode(*grid, codec);
+
+        encodeTime += timer.milliseconds();
+
+        evictCache();
+
+        timer.start();
+
+        FloatGrid::Ptr result = decode(bytes, codec, refTree.background());
+
+        decodeTime += timer.milliseconds();
+
+        total += result->tree().leafCount();
+
+        if (total == 0)     std::cerr << std::endl; // prevent optimization
+    }
+
+    encodeTime /= iterations;
+    decodeTime /= iterations;
+
+    const double megabytes = double(rawBytes) / (1024.0 * 1024.0);
+
+    return Result(encodeTime + decodeTime)
+        .metric("encode", encodeTime, "ms")
+        .metric("decode", decodeTime, "ms")
+        .metric("encode bandwidth", megabytes / (encodeTime / 1000.0), "MB/s")
+        .metric("decode bandwidth", megabytes / (decodeTime / 1000.0), "MB/s")
+        .metric("compression ratio", double(rawBytes) / double(bytes.size()))
+        .metric("bytes per voxel", double(bytes.size()) / double(refTree.activeVoxelCount()));
+}
+
+const bool registered = registerCases("serialize", {
+    { "Cloud Serialize None", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return serialize(ctx.tree(), { "None", io::COMPRESS_NONE, false }, ctx.iterations); } },
+    { "Cloud Serialize Zip", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return serialize(ctx.tree(), { "Zip", io::COMPRESS_ZIP, false }, ctx.iterations); } },
+    { "Cloud Serialize Blosc", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return serialize(ctx.tree(), { "Blosc", io::COMPRESS_BLOSC, false }, ctx.iterations); } },
+    { "Cloud Serialize Active Mask", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return serialize(ctx.tree(), { "Active Mask", io::COMPRESS_ACTIVE_MASK, false }, ctx.iterations); } },
+    { "Cloud Serialize Half Float", Case::Asset | Case::Serial,
+        [](const Context& ctx) { return serialize(ctx.tree(), { "Half Float", io::COMPRESS_NONE, true }, ctx.iterations); } },
+});
+
+} // namespace
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tree/LeafManager.h>
+
+#include <tbb/parallel_for.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "stats.h"
+
+using namespace openvdb;
+
+// an on-disk cache of preprocessed assets, the voxelized tree is stored uncompressed as flat
+// arrays of leaf origins, value masks and value buffers plus a list of the remaining tiles, each
+// array starts on a page boundary so the file can be memory-mapped and the leaf nodes rebuilt
+// in parallel directly from the mapping
+//
+// snapshots are keyed by a hash of the path, size and modification time of the source file and
+// the preprocessing options, so a modified asset or a change in preprocessing never reuses a
+// stale snapshot without the lookup having to read the whole source file
+
+namespace snapshot {
+
+using LeafT = FloatTree::LeafNodeType;
+
+const char Magic[8] = { 'V', 'D', 'B', 'S', 'N', 'A', 'P', '\0' };
+const uint32_t Version = 2;
+const uint64_t Alignment = 4096;
+
+struct Header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t leafSize;
+    uint64_t key;
+    float background;
+    uint32_t padding;
+    uint64_t leafCount;
+    uint64_t tileCount;
+    uint64_t originsOffset;
+    uint64_t masksOffset;
+    uint64_t buffersOffset;
+    uint64_t tilesOffset;
+    uint64_t fileSize;
+    TreeStats stats;        // of the source tree
+};
+
+struct Tile
+{
+    Int32 origin[3];
+    Index32 level;
+    float value;
+    Index32 active;
+};
+
+inline uint64_t align(uint64_t offset)
+{
+    return (offset + Alignment - 1) & ~(Alignment - 1);
+}
+
+// 64-bit FNV-1a, applied eight bytes at a time
+
+inline uint64_t hash(uint64_t key, const char* data, size_t size)
+{
+    const uint64_t prime = 1099511628211ull;
+    size_t i = 0;
+    for ( ; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        key = (key ^ word) * prime;
+    }
+    for ( ; i < size; i++) {
+        key = (key ^ uint64_t(static_cast<unsigned char>(data[i]))) * prime;
+    }
+    return key;
+}
+
+// returns zero if the source file does not exist
+
+inline uint64_t key(const std::string& filepath, const std::string& options)
+{
+    struct stat st;
+    if (stat(filepath.c_str(), &st) != 0)   return 0;
+
+    const uint64_t identity[3] = { uint64_t(st.st_size), uint64_t(st.st_mtim.tv_sec), uint64_t(st.st_mtim.tv_nsec) };
+
+    uint64_t result = 14695981039346656037ull;
+    result = hash(result, filepath.data(), filepath.size());
+    result = hash(result, reinterpret_cast<const char*>(identity), sizeof(identity));
+
+    const std::string salt = options + "/" + std::to_string(Version);
+    return hash(result, salt.data(), salt.size());
+}
+
+inline std::string path(const std::string& directory, uint64_t key)
+{
+    std::ostringstream ss;
+    ss << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".vdbsnap";
+    return ss.str();
+}
+
+// writes to a temporary file that is renamed once complete so that an interrupted write never
+// leaves a truncated snapshot behind, returns false if the snapshot could not be written
+
+inline bool write(const std::string& filepath, uint64_t key, const FloatTree& tree, const TreeStats& stats)
+{
+    tree::LeafManager<const FloatTree> leafManager(tree);
+
+    std::vector<Tile> tiles;
+    auto iter = tree.cbeginValueAll();
+    iter.setMaxDepth(FloatTree::ValueAllCIter::LEAF_DEPTH - 1);
+    for ( ; iter; ++iter) {
+        if (!iter.isTileValue())    continue;
+        if (!iter.isValueOn() && iter.getValue() == tree.background())  continue;
+        CoordBBox bbox;
+        iter.getBoundingBox(bbox);
+        tiles.push_back({ { bbox.min().x(), bbox.min().y(), bbox.min().z() },
+            Index32(iter.getLevel()), iter.getValue(), Index32(iter.isValueOn()) });
+    }
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.leafSize = sizeof(float) * LeafT::SIZE;
+    header.key = key;
+    header.background = tree.background();
+    header.leafCount = leafManager.leafCount();
+    header.tileCount = tiles.size();
+    header.originsOffset = align(sizeof(Header));
+    header.masksOffset = align(header.originsOffset + header.leafCount * sizeof(Coord));
+    header.buffersOffset = align(header.masksOffset + header.leafCount * sizeof(LeafT::NodeMaskType));
+    header.tilesOffset = align(header.buffersOffset + header.leafCount * header.leafSize);
+    header.fileSize = header.tilesOffset + header.tileCount * sizeof(Tile);
+    header.stats = stats;
+
+    const std::string temp = filepath + ".tmp";
+    std::ofstream file(temp, std::ios::binary);
+    if (!file)  return false;
+
+    auto seek = [&](uint64_t offset) {
+        static const char zeros[Alignment] = {};
+        file.write(zeros, std::streamsize(offset - uint64_t(file.tellp())));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    seek(header.originsOffset);
+    for (size_t n = 0; n < leafManager.leafCount(); n++) {
+        const Coord& origin = leafManager.leaf(n).origin();
+        file.write(reinterpret_cast<const char*>(&origin), sizeof(Coord));
+    }
+    seek(header.masksOffset);
+    for (size_t n = 0; n < leafManager.leafCount(); n++) {
+        const auto& mask = leafManager.leaf(n).getValueMask();
+        Index64 words[LeafT::NodeMaskType::WORD_COUNT];
+        for (Index i = 0; i < LeafT::NodeMaskType::WORD_COUNT; i++)  words[i] = mask.getWord<Index64>(i);
+        file.write(reinterpret_cast<const char*>(words), sizeof(words));
+    }
+    seek(header.buffersOffset);
+    for (size_t n = 0; n < leafManager.leafCount(); n++) {
+        file.write(reinterpret_cast<const char*>(leafManager.leaf(n).buffer().data()), header.leafSize);
+    }
+    seek(header.tilesOffset);
+    file.write(reinterpret_cast<const char*>(tiles.data()), std::streamsize(tiles.size() * sizeof(Tile)));
+
+    file.close();
+    if (!file || std::rename(temp.c_str(), filepath.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+// returns a null pointer if there is no valid snapshot with this key
+
+inline FloatTree::Ptr read(const std::string& filepath, uint64_t key, TreeStats& stats)
+{
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)     return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t size = size_t(st.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)     return nullptr;
+
+    const char* bytes = static_cast<const char*>(data);
+    const Header& header = *reinterpret_cast<const Header*>(bytes);
+
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+        header.key != key || header.leafSize != sizeof(float) * LeafT::SIZE || header.fileSize != size) {
+        munmap(data, size);
+        return nullptr;
+    }
+
+    stats = header.stats;
+
+    const Coord* origins = reinterpret_cast<const Coord*>(bytes + header.originsOffset);
+    const char* masks = bytes + header.masksOffset;
+    const char* buffers = bytes + header.buffersOffset;
+    const Tile* tiles = reinterpret_cast<const Tile*>(bytes + header.tilesOffset);
+
+    // allocate and fill the leaf nodes in parallel, then insert them into the tree
+
+    std::vector<LeafT*> leaves(header.leafCount);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, leaves.size()),
+        [&](const tbb::blocked_range<size_t>& range) {
+            for (size_t n = range.begin(); n < range.end(); n++) {
+                LeafT* leaf = new LeafT(origins[n], header.background);
+                std::memcpy(&leaf->getValueMask().getWord<Index64>(0),
+                    masks + n * sizeof(LeafT::NodeMaskType), sizeof(LeafT::NodeMaskType));
+                std::memcpy(leaf->buffer().data(), buffers + n * header.leafSize, header.leafSize);
+                leaves[n] = leaf;
+            }
+        });
+
+    FloatTree::Ptr tree = std::make_shared<FloatTree>(header.background);
+    for (LeafT* leaf : leaves) {
+        tree->addLeaf(leaf);
+    }
+    for (uint64_t n = 0; n < header.tileCount; n++) {
+        const Tile& tile = tiles[n];
+        tree->addTile(tile.level, Coord(tile.origin[0], tile.origin[1], tile.origin[2]), tile.value, tile.active != 0);
+    }
+
+    munmap(data, size);
+
+    return tree;
+}
+
+} // namespace snapshot
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <algorithm>
+
+using namespace openvdb;
+
+// the shape of a tree, computed before its active tiles are voxelized so that the results of
+// benchmarks can be related to the sparsity of the data they ran on
+
+struct TreeStats
+{
+    Index64 activeVoxelCount = 0;       // including the voxels of active tiles
+    Index64 activeLeafVoxelCount = 0;
+    Index64 leafCount = 0;
+    Index64 activeTileCount = 0;
+    Index64 rootChildCount = 0;
+    double minFill = 0.0;               // fraction of the voxels of a leaf that are active
+    double meanFill = 0.0;
+    double maxFill = 0.0;
+    double tileVoxelRatio = 0.0;        // active tile voxels per active leaf voxel
+};
+
+inline TreeStats treeStats(const FloatTree& tree)
+{
+    TreeStats stats;
+    stats.activeVoxelCount = tree.activeVoxelCount();
+    stats.activeLeafVoxelCount = tree.activeLeafVoxelCount();
+    stats.leafCount = tree.leafCount();
+    stats.activeTileCount = tree.activeTileCount();
+    stats.rootChildCount = tree.root().childCount();
+
+    if (stats.leafCount > 0) {
+        stats.minFill = 1.0;
+        for (auto leaf = tree.cbeginLeaf(); leaf; ++leaf) {
+            const double fill = double(leaf->onVoxelCount()) / double(FloatTree::LeafNodeType::SIZE);
+            stats.minFill = std::min(stats.minFill, fill);
+            stats.maxFill = std::max(stats.maxFill, fill);
+        }
+        stats.meanFill = double(stats.activeLeafVoxelCount) /
+            (double(stats.leafCount) * double(FloatTree::LeafNodeType::SIZE));
+    }
+
+    stats.tileVoxelRatio = double(stats.activeVoxelCount - stats.activeLeafVoxelCount) /
+        double(std::max(stats.activeLeafVoxelCount, Index64(1)));
+
+    return stats;
+}
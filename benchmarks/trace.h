@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+// a minimal recorder of Chrome trace-event spans (load the output in chrome://tracing or Perfetto)
+//
+// every thread appends to its own fixed-capacity ring buffer, so recording a span never takes a
+// lock, once a ring buffer is full the oldest spans are overwritten
+
+struct TraceEvent
+{
+    const char* name;
+    int process;
+    uint64_t begin;     // nanoseconds since the tracer was created
+    uint64_t end;
+    size_t first;       // index of the first and last node processed by this span
+    size_t last;
+};
+
+struct TraceBuffer
+{
+    TraceBuffer(size_t capacity, int thread_):
+        events(capacity), thread(thread_) { }
+
+    void push(const TraceEvent& event)
+    {
+        events[count++ % events.size()] = event;
+    }
+
+    // spans of consecutive node indices processed by this thread are merged into a single
+    // span that covers the whole chunk of a range that was handed to this thread by TBB
+
+    void close()
+    {
+        if (open)   this->push(current);
+        open = false;
+    }
+
+    std::vector<TraceEvent> events;
+    size_t count = 0;
+    int thread;
+    bool open = false;
+    TraceEvent current;
+    TraceBuffer* next = nullptr;
+};
+
+// escapes quotes, backslashes and control characters for use in a JSON string
+
+inline std::string jsonEscape(const std::string& str)
+{
+    std::string result;
+    for (char c : str) {
+        if (c == '"' || c == '\\')  result += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) {
+            char code[7];
+            std::snprintf(code, sizeof(code), "\\u%04x", unsigned(c));
+            result += code;
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+class Tracer
+{
+public:
+    ~Tracer()
+    {
+        for (TraceBuffer* buffer = mHead.load(); buffer; ) {
+            TraceBuffer* next = buffer->next;
+            delete buffer;
+            buffer = next;
+        }
+    }
+
+    bool enabled() const { return mEnabled; }
+    void enable() { mEnabled = true; }
+
+    uint64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - mStart).count();
+    }
+
+    // spans recorded from now on are grouped under a new process with this name
+
+    void beginProcess(const std::string& name)
+    {
+        mProcesses.push_back(name);
+    }
+
+    int process() const { return int(mProcesses.size()) - 1; }
+
+    TraceBuffer& local()
+    {
+        thread_local TraceBuffer* buffer = nullptr;
+        if (!buffer) {
+            buffer = new TraceBuffer(mCapacity, mThreads++);
+            buffer->next = mHead.load();
+            while (!mHead.compare_exchange_weak(buffer->next, buffer)) { }
+        }
+        return *buffer;
+    }
+
+    // close the open chunks of all threads, only call outside of a parallel section
+
+    void flush()
+    {
+        for (TraceBuffer* buffer = mHead.load(); buffer; buffer = buffer->next) {
+            buffer->close();
+        }
+    }
+
+    void write(const std::string& filepath)
+    {
+        this->flush();
+
+        // timestamps are in microseconds with nanosecond precision, so that short chunks and
+        // the gaps between them are not rounded away late in a long run
+
+        std::ofstream file(filepath);
+        file << std::fixed << std::setprecision(3);
+        file << "{\"traceEvents\": [\n";
+        bool first = true;
+        auto separator = [&]() -> const char* { if (first) { first = false; return ""; } return ",\n"; };
+
+        for (size_t i = 0; i < mProcesses.size(); i++) {
+            file << separator() << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << i <<
+                ", \"args\": {\"name\": \"" << jsonEscape(mProcesses[i]) << "\"}}";
+        }
+
+        for (TraceBuffer* buffer = mHead.load(); buffer; buffer = buffer->next) {
+            const size_t size = std::min(buffer->count, buffer->events.size());
+            for (size_t i = buffer->count - size; i < buffer->count; i++) {
+                const TraceEvent& event = buffer->events[i % buffer->events.size()];
+                file << separator() << "{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": " <<
+                    event.process << ", \"tid\": " << buffer->thread << ", \"ts\": " << event.begin / 1000.0 <<
+                    ", \"dur\": " << (event.end - event.begin) / 1000.0 << ", \"args\": {\"first\": " <<
+                    event.first << ", \"last\": " << event.last << ", \"count\": " <<
+                    event.last - event.first + 1 << "}}";
+            }
+            if (buffer->count > buffer->events.size()) {
+                std::cerr << "trace ring buffer of thread " << buffer->thread << " overflowed, " <<
+                    buffer->count - buffer->events.size() << " spans were dropped\n";
+            }
+        }
+
+        file << "\n]}\n";
+    }
+
+private:
+    bool mEnabled = false;
+    size_t mCapacity = 1 << 16;
+    std::atomic<int> mThreads{0};
+    std::atomic<TraceBuffer*> mHead{nullptr};
+    std::vector<std::string> mProcesses;
+    std::chrono::steady_clock::time_point mStart = std::chrono::steady_clock::now();
+};
+
+inline Tracer& tracer()
+{
+    static Tracer instance;
+    return instance;
+}
+
+// records a single span on the calling thread for the lifetime of this object and
+// closes the open chunks of all threads on destruction
+
+class TraceScope
+{
+public:
+    TraceScope(const char* name):
+        mName(name), mBegin(tracer().enabled() ? tracer().now() : 0) { }
+
+    ~TraceScope()
+    {
+        if (!tracer().enabled())    return;
+        tracer().flush();
+        tracer().local().push({mName, tracer().process(), mBegin, tracer().now(), 0, 0});
+    }
+
+private:
+    const char* mName;
+    uint64_t mBegin;
+};
+
+template <typename NodeT>
+inline const char* traceLevelName()
+{
+    static const char* const names[4] = { "Leaf", "Internal1", "Internal2", "Root" };
+    return names[std::min(int(NodeT::LEVEL), 3)];
+}
+
+// records a single span on the calling thread for the chunk of nodes [first, last] that is
+// processed by the func
+
+template <typename FuncT>
+inline void traceChunk(const char* name, size_t first, size_t last, const FuncT& func)
+{
+    const uint64_t begin = tracer().now();
+    func();
+    tracer().local().push({name, tracer().process(), begin, tracer().now(), first, last});
+}
+
+// runs op(node, index) over the nodes the same way that the LeafManager and NodeManager process
+// a single level, with one parallel_for over the node array, recording one span for every range
+// that TBB hands to a thread
+
+template <typename NodeT, typename OpT>
+inline void traceForeach(const std::vector<NodeT*>& nodes, const OpT& op, bool threaded, size_t grainSize)
+{
+    if (nodes.empty())  return;
+
+    auto body = [&](const tbb::blocked_range<size_t>& range) {
+        traceChunk(traceLevelName<NodeT>(), range.begin(), range.end() - 1, [&]() {
+            for (size_t n = range.begin(); n < range.end(); n++) {
+                op(*nodes[n], n);
+            }
+        });
+    };
+
+    if (threaded)   tbb::parallel_for(tbb::blocked_range<size_t>(0, nodes.size(), grainSize), body);
+    else            body(tbb::blocked_range<size_t>(0, nodes.size()));
+}
+
+// wraps a DynamicNodeManager operator to record spans of nodes, the DynamicNodeManager does not
+// expose its ranges so spans are rebuilt from the node indices it passes to the operator, which
+// merges contiguous ranges that are processed back to back by one thread into a single span
+
+template <typename OpT>
+struct TraceOp
+{
+    TraceOp(const OpT& op_): op(op_) { }
+
+    template <typename NodeT>
+    bool operator()(NodeT& node, size_t idx = 0) const
+    {
+        const char* name = traceLevelName<NodeT>();
+
+        TraceBuffer& buffer = tracer().local();
+        const uint64_t begin = tracer().now();
+        if (!buffer.open || buffer.current.name != name || idx != buffer.current.last + 1) {
+            buffer.close();
+            buffer.current = {name, tracer().process(), begin, begin, idx, idx};
+            buffer.open = true;
+        }
+
+        bool result = op(node, idx);
+
+        buffer.current.last = idx;
+        buffer.current.end = tracer().now();
+        return result;
+    }
+
+    const OpT& op;
+};